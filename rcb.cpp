@@ -0,0 +1,235 @@
+/**
+ * =====================
+ * RCB - RC16 BENCHMARKS
+ * =====================
+ *
+ * MAIN
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#include <chrono>
+#include "src/main.hpp"
+#include "src/microops.cpp"
+#include "src/emulator.cpp"
+#include "src/threaded.cpp"
+#include "src/jit.cpp"
+#include "src/synth.cpp"
+#include "src/isa.cpp"
+#include "src/peephole.cpp"
+#include "src/lexer.cpp"
+#include "src/expr.cpp"
+#include "src/runtime.cpp"
+#include "src/parser.cpp"
+#include "src/image.cpp"
+
+// Heap usage, counted by the replaced global allocation and deallocation functions below. All of their forms go through
+// the same two functions, kept out of line so that the compiler does not pair their malloc and free with the callers.
+static size_t alloc_bytes = 0, alloc_count = 0;
+[[gnu::noinline]] static void *counted(const size_t n, const size_t align = 0) {
+	alloc_bytes += n;
+	++alloc_count;
+	return (align > alignof(max_align_t)) ? aligned_alloc(align, (n + align - 1) / align * align) : malloc(n);
+}
+void *operator new(size_t n) { if (void *p = counted(n)) return p; throw bad_alloc(); }
+void *operator new[](size_t n) { return operator new(n); }
+void *operator new(size_t n, align_val_t a) { if (void *p = counted(n, (size_t)a)) return p; throw bad_alloc(); }
+void *operator new[](size_t n, align_val_t a) { return operator new(n, a); }
+void *operator new(size_t n, const nothrow_t &) noexcept { return counted(n); }
+void *operator new[](size_t n, const nothrow_t &) noexcept { return counted(n); }
+[[gnu::noinline]] void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { operator delete(p); }
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+void operator delete[](void *p, size_t) noexcept { operator delete(p); }
+void operator delete(void *p, align_val_t) noexcept { operator delete(p); }
+void operator delete[](void *p, align_val_t) noexcept { operator delete(p); }
+void operator delete(void *p, size_t, align_val_t) noexcept { operator delete(p); }
+void operator delete[](void *p, size_t, align_val_t) noexcept { operator delete(p); }
+
+// Synthetic programs
+#define gen_labels		0x0 // Thousands of code labels, with jumps and calls between them
+#define gen_put			0x1 // Dense PUTs of data labels and CALs
+#define gen_data		0x2 // Big data tables
+#define gen_code		0x3 // Code segment filled up to its limit
+const vector<string> gen_names = { "labels", "put", "data", "code" };
+
+// Prints usage help.
+// @return		String with usage help.
+string help() {
+	oss os;
+	os << "Usage: rcb [options]" << nl <<
+	"Runs the assembler on synthetic programs and the emulator on 'programs/bench', and checks the output of the optimizer," << nl <<
+	"printing one JSON object per result." << nl <<
+	"Options:" << nl <<
+	" -r <arg>	Repetitions of every benchmark (the fastest one is reported). Default: 5." << nl <<
+	" -p <arg>	Directory of execution benchmarks. Default: 'programs/bench'." << nl <<
+	" -w <arg>	Directory generated programs and images are written to. Default: '/tmp'." << nl <<
+	" -g <arg>	Only print a synthetic program (labels, put, data or code)." << nl <<
+	" -h		Print this help.";
+	return os.str();
+}
+
+// Generate a synthetic program.
+// Every kind stays within the code segment (16K microops), so that all of its jumps can be encoded.
+// @param kind		Kind of program (gen_*).
+// @param seed		Seed of the pseudo-random choices.
+// @return			Program text.
+string generate(const uint8_t kind, uint32_t seed = 1) {
+	auto rnd = [&](const uint32_t n) { seed = seed * 1103515245 + 12345; return (seed >> 8) % n; };
+	auto r = [&]() { return "r" + to_string(rnd(5)); };
+	oss os;
+	os << "# SYNTHETIC PROGRAM: " << gen_names[kind] << nl << nl << ".data" << nl;
+	if (kind == gen_put) for (int i = 0; i < 1000; ++i) os << "    &d" << i << "= " << rnd(0x10000) << nl;
+	if (kind == gen_data) for (int i = 0; i < 1000; ++i) { // 16000 words
+		os << "    &t" << i << "= " << rnd(0x10000);
+		for (int j = 1; j < 16; ++j) os << ", " << rnd(0x10000);
+		os << nl;
+	}
+	os << nl << ".prgm" << nl << "    &main" << nl;
+	switch (kind) {
+		case gen_labels:
+			for (int i = 0; i < 3000; ++i) {
+				os << "    &l" << i << nl << "        prt: " << r() << nl;
+				if (rnd(4) == 0) os << "        jmpne: $l" << rnd(3000) << nl;
+				else os << "        mov: " << r() << ", " << r() << nl;
+			}
+			break;
+		case gen_put:
+			for (int i = 0; i < 800; ++i) {
+				os << "        put: " << r() << ", $d" << rnd(1000) << nl;
+				if (rnd(2) == 0) os << "        cal: $f" << rnd(50) << nl;
+			}
+			os << "        hlt" << nl;
+			for (int i = 0; i < 50; ++i) os << "    &f" << i << nl << "        add: " << r() << ", " << r() << ", " << r() << nl << "        ret" << nl;
+			break;
+		case gen_data:
+			for (int i = 0; i < 1000; ++i) os << "        put: " << r() << ", $t" << rnd(1000) << nl << "        ldr: " << r() << ", " << r() << nl;
+			break;
+		case gen_code:
+			for (int i = 0; i < 4090; ++i) os << "        add: " << r() << ", " << r() << ", " << r() << nl;
+			os << "        jmp: $main" << nl;
+			break;
+	}
+	os << "        hlt" << nl;
+	return os.str();
+}
+
+// Print a result as a JSON object.
+// @param fields	Names and values (already formatted) of its fields.
+void report(const vector<pair<string,string>> &fields) {
+	cout << "{";
+	for (size_t i = 0; i < fields.size(); ++i) cout << (i > 0 ? ", " : "") << "\"" << fields[i].first << "\": " << fields[i].second;
+	cout << "}" << nl;
+}
+
+// Quote a string for JSON.
+// @param s		String (without quotes or backslashes).
+// @return		Quoted string.
+string q(const string &s) { return "\"" + s + "\""; }
+
+// Main.
+int main(int argc, char* argv[]) {
+	int reps = 5;
+	string pdir = "programs/bench", wdir = "/tmp";
+	// Parse command line options
+	int opt;
+	while ((opt = getopt(argc, argv, "r:p:w:g:h")) != -1) {
+		switch (opt) {
+			case 'r':
+				reps = max(1, atoi(optarg));
+				break;
+			case 'p':
+				pdir = string(optarg);
+				break;
+			case 'w':
+				wdir = string(optarg);
+				break;
+			case 'g': {
+				auto it = find(gen_names.begin(), gen_names.end(), string(optarg));
+				if (it == gen_names.end()) { cerr << "Unknown synthetic program." << nl; return -1; }
+				cout << generate(it - gen_names.begin());
+				return 0;
+			}
+			case 'h':
+				cout << help() << nl;
+				return 0;
+			default:
+				cerr << help() << nl;
+				return -1;
+		}
+	}
+	synthesis(); // Built once per process: not part of any benchmark
+	// Assembler
+	for (uint8_t kind = gen_labels; kind <= gen_code; ++kind) {
+		string src = wdir + "/rcb_" + gen_names[kind] + ".rc", text = generate(kind);
+		ofs(src) << text;
+		size_t lines = count(text.begin(), text.end(), '\n');
+		for (int o = 0; o <= 1; ++o) {
+			double best = 1e9;
+			size_t bytes = 0, allocs = 0, microops = 0;
+			for (int i = 0; i < reps; ++i) {
+				oss err;
+				size_t b0 = alloc_bytes, a0 = alloc_count;
+				auto t0 = chrono::steady_clock::now();
+				program prg = parsePrg(src, err, o);
+				double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+				if (secs < best) { best = secs; bytes = alloc_bytes - b0; allocs = alloc_count - a0; } // Everything from the fastest run
+				microops = prg.code.size();
+				if (prg.errors > 0) { cerr << src << ": " << err.str(); return 1; }
+			}
+			report({ {"suite", q("asm")}, {"name", q(gen_names[kind])}, {"opt", to_string(o)}, {"lines", to_string(lines)},
+				{"microops", to_string(microops)}, {"secs", to_string(best)}, {"lines_per_sec", to_string((uint64_t)(lines / best))},
+				{"alloc_bytes", to_string(bytes)}, {"allocs", to_string(allocs)} });
+		}
+	}
+	// Optimizer: a then/else diamond becomes straight-line code at -O2
+	{
+		string src = wdir + "/rcb_diamond.rc";
+		ofs(src) << ".prgm\n&main\ncmp: r0, r1\njmpeq: $else\nmov: r2, r0\njmp: $join\n&else\nmov: r2, r1\n&join\nprt: r2\nhlt\n";
+		oss err;
+		program prg = parsePrg(src, err, 2);
+		bool jumps = any_of(prg.code.begin(), prg.code.end(), [](const uint16_t w) { return !(w & 0x8000) && (w & 0x1); }); // LJRs
+		report({ {"suite", q("opt")}, {"name", q("diamond")}, {"microops", to_string(prg.code.size())}, {"ok", (prg.errors == 0 && !jumps) ? "true" : "false"} });
+		if (prg.errors > 0 || jumps) { cerr << src << ": Branches left at -O2." << nl << err.str(); return 1; }
+	}
+	// Emulator
+	for (const string name : { "mul", "sort", "memcpy", "print" }) {
+		string src = pdir + "/" + name + ".rc", img = wdir + "/rcb_" + name + ".bin";
+		if (!fexists(src)) { cerr << src << ": Given file does not exist or is unaccessible." << nl; return 1; }
+		oss err;
+		program prg = parsePrg(src, err, true);
+		if (prg.errors > 0) { cerr << src << ": " << err.str(); return 1; }
+		ofs bin(img, ios::binary);
+		writeImg(bin, prg, img_flat);
+		bin.close();
+		vector<uint16_t> ref; // Output of the basic interpreter
+		for (const string engine : { "basic", "threaded", "jit" }) {
+			double best = 1e9;
+			uint64_t cyc = 0;
+			bool same = true;
+			for (int i = 0; i < reps; ++i) {
+				rc16 *m = new rc16();
+				loadImg(*m, img);
+				auto t0 = chrono::steady_clock::now();
+				if (engine.compare("basic") == 0) run(*m, UINT64_MAX);
+				else if (engine.compare("threaded") == 0) {
+					pdcache *dc = new pdcache();
+					runThreaded(*m, UINT64_MAX, *dc);
+					delete dc;
+				} else {
+					jit *j = new jit();
+					j->execute(*m, UINT64_MAX);
+					delete j;
+				}
+				best = min(best, chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+				cyc = m->cyc;
+				if (ref.empty()) ref = m->out;
+				same = same && m->hlt && m->out == ref;
+				delete m;
+			}
+			report({ {"suite", q("exec")}, {"name", q(name)}, {"engine", q(engine)}, {"microops", to_string(cyc)},
+				{"secs", to_string(best)}, {"mops_per_sec", to_string((uint64_t)(cyc / best / 1e6))}, {"ok", same ? "true" : "false"} });
+		}
+	}
+	return 0;
+}
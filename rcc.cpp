@@ -8,53 +8,176 @@
  * 05/10/2019
  */
 
+#include <thread>
+#include <atomic>
+#include <iomanip>
+#include <map>
 #include "src/main.hpp"
 #include "src/microops.cpp"
+#include "src/emulator.cpp"
+#include "src/synth.cpp"
 #include "src/isa.cpp"
+#include "src/peephole.cpp"
+#include "src/lexer.cpp"
+#include "src/expr.cpp"
+#include "src/runtime.cpp"
 #include "src/parser.cpp"
+#include "src/casm.cpp"
+#include "src/object.cpp"
+#include "src/image.cpp"
+#include "src/listing.cpp"
+
+// Program assembled at compile time (see 'casm'), so that changes to the parser which break it break the build of rcc.
+constexpr const char *casm_test = ".data\n&n= 5, 16\n.prgm\n&main\nput: r1, $n+1\nldr: r0, r1\nput: r2, $end\njmpne: $end\nprt: r0\n&end\nhlt\n";
+static_assert(casmdat<casmdatlen(casm_test)>(casm_test) == array<uint16_t,2>{ 0x0005, 0x0010 });
+static_assert(casm<casmlen(casm_test)>(casm_test) == array<uint16_t,20>{ 0x8049, 0x4036, 0x4200, 0x8204, 0x8246, 0xc280, 0x4150, 0x8240, 0xc100, 0x4150,
+	0x8246, 0xc280, 0x4150, 0x8253, 0xc100, 0x4144, 0x0027, 0x49ae, 0x4018, 0x0200 });
 
 // Prints usage help.
 // @return		String with usage help.
 string help() {
 	oss os;
 	os << "Usage: rcc [options]" << nl <<
+	"       rcc [options] <file>.rc ..." << nl <<
 	"Options:" << nl <<
-	" -i <arg>	Input file to be compiled [REQUIRED]." << nl <<
-	" -o <arg>	Output file name." << nl <<
+	" -i <arg>	Input file to be compiled [REQUIRED, unless given otherwise]. May be repeated." << nl <<
+	" -o <arg>	Output file name (single input only). Default: 'a.bin', or '<file>.bin' next to each of many inputs." << nl <<
+	" -m <arg>	Manifest file listing input files, one per line." << nl <<
+	" -j <arg>	Number of files compiled in parallel. Default: number of hardware threads." << nl <<
+	" -O		Remove redundant microops from the program." << nl <<
+	" -O2, -O 2	Also optimize calls: CALs followed by RET become jumps, small leaf functions are inlined, and functions" << nl <<
+	"		which call others save LR on the stack by themselves, dropping saves of registers no caller reads; short" << nl <<
+	"		forward branches become predicated code." << nl <<
+	" -f <arg>	Image format: raw (Logisim 'v2.0 raw'), flat (128kB little-endian memory dump) or seg (segmented). Default: raw." << nl <<
+	" -c		Assemble into relocatable objects ('a.rco', or '<file>.rco'), to be linked by rcl." << nl <<
+	" -g		Also write the symbols of every program ('<file>.sym' next to its image), for profiling by rce." << nl <<
+	" -l		Also write the listing of every program ('<file>.lst' next to its image): address, microops and cycles of every" << nl <<
+	"		source line, size of every label and cycles per iteration of every loop." << nl <<
 	" -h		Print this help.";
 	return os.str();
 }
 
-// Compile a program into a binary file.
+// Compile a program into a binary file, which is not written if the program has errors.
 // @param src		Source filename.
 // @param dst		Destination filename.
-void compilePrg(const string &src, const string &dst) {
-	ofs bin(dst);
-	// Header
-	bin << "v2.0 raw" << nl;
-	// Init instructions
-	bin << SET(A, 0) << " " << EXC(NOT, false, false) << " " << MOVREG(OUT, SP) << nl; // SP = mem_estk (0xffff)
-	bin << SET(A, 32) << " " << SET(B, 9) << " " << EXC(LSL, false, false) << " " << MOVREG(OUT, LR) << nl; // LR = mem_iprg (0x4000)
-	bin << MOVREG(OUT, PC) << nl; // PC = mem_iprg (0x4000)
-	// Parse program
-	bin << parsePrg(src) << nl;
-	bin << HLT();
+// @param opt		Optimization level (see 'parsePrg').
+// @param err		Stream errors are reported to.
+// @param reloc		Write a relocatable object instead of a memory image.
+// @param fmt		Image format.
+// @param sym		Also write the symbols of the program, into '<dst>.sym' (with the extension of dst replaced).
+// @param lst		Also write the listing of the program, into '<dst>.lst'.
+// @return			True if the program compiled without errors, false otherwise.
+bool compilePrg(const string &src, const string &dst, const int &opt, ostream &err, const bool &reloc = false, const uint8_t fmt = img_raw, const bool &sym = false, const bool &lst = false) {
+	if (!fexists(src)) { err << "Given file does not exist or is unaccessible." << nl; return false; } // Check src existence and accessibility
+	object obj;
+	program prg;
+	if (reloc) obj = assemble(src, err, true, opt >= 2);
+	else prg = parsePrg(src, err, opt);
+	if ((reloc ? obj.errors : prg.errors) > 0) return false;
+	ofs bin(dst, ios::binary);
+	if (!bin) { err << "Cannot write '" << dst << "'." << nl; return false; }
+	if (reloc) writeObj(bin, obj);
+	else writeImg(bin, prg, fmt);
 	bin.close();
+	if (sym && !reloc) {
+		ofs sf(binName(dst, ".sym"));
+		if (!sf) { err << "Cannot write '" << binName(dst, ".sym") << "'." << nl; return false; }
+		writeSym(sf, prg);
+	}
+	if (lst && !reloc) {
+		ofs lf(binName(dst, ".lst"));
+		if (!lf) { err << "Cannot write '" << binName(dst, ".lst") << "'." << nl; return false; }
+		writeLst(lf, prg);
+	}
+	return true;
+}
+
+// Compile many programs on a pool of threads, each one into '<file>.bin' (or '<file>.rco') next to its source.
+// Diagnostics are collected per file and printed in input order once every file is done.
+// @param srcs		Source filenames.
+// @param opt		Optimization level.
+// @param jobs		Number of threads.
+// @param reloc		Write relocatable objects.
+// @param fmt		Image format.
+// @param sym		Also write symbol files.
+// @param lst		Also write listings.
+// @return			Number of programs which failed to compile.
+int compileAll(const vector<string> &srcs, const int &opt, const unsigned &jobs, const bool &reloc, const uint8_t fmt, const bool &sym, const bool &lst) {
+	vector<string> diag(srcs.size());
+	vector<char> ok(srcs.size(), false);
+	atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (size_t i; (i = next++) < srcs.size();) {
+			oss err;
+			ok[i] = compilePrg(srcs[i], binName(srcs[i], reloc ? ".rco" : ".bin"), opt, err, reloc, fmt, sym, lst);
+			diag[i] = err.str();
+		}
+	};
+	vector<thread> pool;
+	for (unsigned t = 1; t < min<size_t>(jobs, srcs.size()); ++t) pool.pb(thread(worker));
+	worker();
+	for (thread &t : pool) t.join();
+	int failed = 0;
+	for (size_t i = 0; i < srcs.size(); ++i) {
+		iss lines(diag[i]);
+		for (string line; getline(lines, line);) cerr << srcs[i] << ": " << line << nl;
+		failed += !ok[i];
+	}
+	return failed;
 }
 
 // Main.
 int main(int argc, char* argv[]) {
-	string ifile = "", ofile = "";
+	vector<string> ifiles;
+	string ofile = "";
+	int optimize = 0;
+	uint8_t fmt = img_raw;
+	bool reloc = false;
+	bool sym = false, lst = false;
+	unsigned jobs = max(1u, thread::hardware_concurrency());
 	// Parse command line options
 	int opt;
-	while ((opt = getopt(argc, argv, "i:o:h")) != -1) {
+	while ((opt = getopt(argc, argv, "i:o:m:j:O::f:cglh")) != -1) {
 		switch (opt) {
 			case 'i':
-				ifile = string(optarg);
+				ifiles.pb(string(optarg));
 				break;
 			case 'o':
 				ofile = string(optarg);
 				break;
+			case 'm': {
+				ifs mf(optarg);
+				if (!mf) { cerr << "Given manifest does not exist or is unaccessible." << nl; return -1; }
+				for (string line; getline(mf, line);) if (trim(line).length() > 0 && trim(line)[0] != '#') ifiles.pb(string(trim(line)));
+				break;
+			}
+			case 'j':
+				jobs = max(1, atoi(optarg));
+				break;
+			case 'O': {
+				string level = optarg ? string(optarg) : "1";
+				if (!optarg && optind < argc && string(argv[optind]).find_first_not_of("0123456789") == string::npos && !fexists(argv[optind])) level = argv[optind++]; // '-O 2'
+				if (level.length() != 1 || level[0] > '2') { cerr << "Invalid optimization level." << nl; return -1; }
+				optimize = level[0] - '0';
+				break;
+			}
+			case 'f':
+				try {
+					fmt = imgFormat(string(optarg));
+				} catch (invalid_argument &e) {
+					cerr << e.what() << nl;
+					return -1;
+				}
+				break;
+			case 'c':
+				reloc = true;
+				break;
+			case 'g':
+				sym = true;
+				break;
+			case 'l':
+				lst = true;
+				break;
 			case 'h':
 				cout << help() << nl;
 				return 0;
@@ -63,10 +186,13 @@ int main(int argc, char* argv[]) {
 				return -1;
 		}
 	}
-	if (ifile.compare("") == 0) { cerr << "No input file given." << nl; return -1; }
-	if (!fexists(ifile)) { cerr << "Given file does not exist or is unaccessible." << nl; return -1; } // Check ifile existence and accessibility
-	if (ofile.compare("") == 0) ofile = "a.bin"; // If ofile not given
+	for (int i = optind; i < argc; ++i) ifiles.pb(string(argv[i]));
+	if (ifiles.empty()) { cerr << "No input file given." << nl; return -1; }
 	// Compile given program
-	compilePrg(ifile, ofile);
-	return 0;
-}
\ No newline at end of file
+	if (ifiles.size() == 1) {
+		if (ofile.compare("") == 0) ofile = reloc ? "a.rco" : "a.bin"; // If ofile not given
+		return compilePrg(ifiles[0], ofile, optimize, cerr, reloc, fmt, sym, lst) ? 0 : 1;
+	}
+	if (ofile.compare("") != 0) { cerr << "An output file name can only be given for a single input file." << nl; return -1; }
+	return compileAll(ifiles, optimize, jobs, reloc, fmt, sym, lst) > 0 ? 1 : 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * ===================
+ * RCE - RC16 EMULATOR
+ * ===================
+ *
+ * MAIN
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <deque>
+#include <memory>
+#include "src/main.hpp"
+#include "src/emulator.cpp"
+#include "src/threaded.cpp"
+#include "src/jit.cpp"
+#include "src/profiler.cpp"
+#include "src/snapshot.cpp"
+#include "src/batch.cpp"
+
+// Prints usage help.
+// @return		String with usage help.
+string help() {
+	oss os;
+	os << "Usage: rce [options]" << nl <<
+	"Options:" << nl <<
+	" -i <arg>	Image file to be executed [REQUIRED, unless resuming from a snapshot]." << nl <<
+	" -e <arg>	Execution engine: 'basic' (fetch-decode loop), 'threaded' (predecoded, default) or 'jit' (x86-64 translation)." << nl <<
+	" -c		Check every translated block against the basic interpreter (with '-e jit')." << nl <<
+	" -n <arg>	Maximum number of microops to execute. Default: unlimited." << nl <<
+	" -d		Print output register values in decimal instead of hexadecimal." << nl <<
+	" -s		Print execution statistics." << nl <<
+	" -p <arg>	Profile the execution (with the basic interpreter): write collapsed stacks to the given file, for flame graphs," << nl <<
+	"		and print a summary of microops by label, function, loop, source line and class." << nl <<
+	" -y <arg>	Symbol file of the image, written by 'rcc -g' or 'rcl -g'. Default: '<image>.sym', if any." << nl <<
+	" -b <arg>	Batch mode: run one instance of the program per line of the given file, which lists (hexadecimal) words" << nl <<
+	"		written into its memory before it starts; instances run in lockstep groups, and the output of each one is" << nl <<
+	"		printed on a line of its own." << nl <<
+	" -a <arg>	Address the words of every instance are written from (batch mode). Default: start of data section (0x8)." << nl <<
+	" -r <arg>	Resume from a snapshot (written by '-w') instead of starting from an image." << nl <<
+	" -w <arg>	Write a snapshot of the machine to the given file when the execution stops (it halted, or '-n' microops were" << nl <<
+	"		executed: the limit is not an error then)." << nl <<
+	" -h		Print this help.";
+	return os.str();
+}
+
+// Main.
+int main(int argc, char* argv[]) {
+	string ifile = "", engine = "threaded", pfile = "", yfile = "", bfile = "", rfile = "", wfile = "";
+	uint16_t baddr = mem_idat;
+	uint64_t max = UINT64_MAX;
+	bool dec = false, stats = false, check = false;
+	// Parse command line options
+	int opt;
+	while ((opt = getopt(argc, argv, "i:e:n:cdsp:y:b:a:r:w:h")) != -1) {
+		switch (opt) {
+			case 'i':
+				ifile = string(optarg);
+				break;
+			case 'e':
+				engine = string(optarg);
+				break;
+			case 'n':
+				max = stoull(optarg);
+				break;
+			case 'c':
+				check = true;
+				break;
+			case 'd':
+				dec = true;
+				break;
+			case 's':
+				stats = true;
+				break;
+			case 'p':
+				pfile = string(optarg);
+				break;
+			case 'y':
+				yfile = string(optarg);
+				break;
+			case 'b':
+				bfile = string(optarg);
+				break;
+			case 'a':
+				baddr = stoul(optarg, nullptr, 16);
+				break;
+			case 'r':
+				rfile = string(optarg);
+				break;
+			case 'w':
+				wfile = string(optarg);
+				break;
+			case 'h':
+				cout << help() << nl;
+				return 0;
+			default:
+				cerr << help() << nl;
+				return -1;
+		}
+	}
+	if (ifile.compare("") == 0 && rfile.compare("") == 0) { cerr << "No image file given." << nl; return -1; }
+	if (bfile.compare("") != 0 && wfile.compare("") != 0) { cerr << "Snapshots cannot be written in batch mode." << nl; return -1; }
+	if (engine.compare("basic") != 0 && engine.compare("threaded") != 0 && engine.compare("jit") != 0) { cerr << "Unknown execution engine." << nl; return -1; }
+	unique_ptr<rc16> m = make_unique<rc16>();
+	try {
+		if (rfile.compare("") != 0) restore(*m, readSnap(rfile));
+		else loadImg(*m, ifile);
+	} catch (exception &e) {
+		cerr << "Error: " << e.what() << nl;
+		return -1;
+	}
+	if (bfile.compare("") != 0) { // Batch mode
+		ifs in(bfile);
+		if (!in) { cerr << "Given input file does not exist or is unaccessible." << nl; return -1; }
+		vector<vector<uint16_t>> inputs;
+		string line, w;
+		while (getline(in, line)) {
+			iss ls(line);
+			inputs.pb({});
+			try {
+				while (ls >> w) inputs.back().pb(stoul(w, nullptr, 16));
+			} catch (logic_error &e) {
+				cerr << "Invalid word '" << w << "' on line " << inputs.size() << " of the input file." << nl;
+				return -1;
+			}
+		}
+		unique_ptr<batch> bt = make_unique<batch>(*m, inputs.size());
+		for (size_t l = 0; l < inputs.size(); ++l) for (size_t i = 0; i < inputs[l].size(); ++i) bt->wr(l, baddr + i, inputs[l][i]);
+		auto t0 = chrono::steady_clock::now();
+		uint64_t cyc = runBatch(*bt, max);
+		double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+		size_t running = 0;
+		for (size_t l = 0; l < bt->n; ++l) {
+			for (size_t i = 0; i < bt->out[l].size(); ++i) cout << (i > 0 ? " " : "") << (dec ? to_string(bt->out[l][i]) : bin2hex(bt->out[l][i]));
+			cout << nl;
+			running += !bt->halted(l);
+		}
+		if (stats) cerr << "Instances: " << bt->n << nl << "Microops: " << cyc << nl << "Time: " << fixed << setprecision(6) << secs << " s" << nl << "Speed: " << setprecision(1) << (secs > 0 ? cyc / secs / 1e6 : 0) << " Mops/s" << nl;
+		if (running > 0) { cerr << "Microop limit reached before HLT by " << running << " instances." << nl; return 1; }
+		return 0;
+	}
+	symbols sym;
+	if (yfile.compare("") == 0 && ifile.compare("") != 0 && fexists(binName(ifile, ".sym"))) yfile = binName(ifile, ".sym");
+	if (pfile.compare("") != 0 && yfile.compare("") != 0) {
+		try {
+			sym = readSym(yfile);
+		} catch (exception &e) {
+			cerr << "Error: " << e.what() << nl;
+			return -1;
+		}
+	}
+	unique_ptr<profile> prof = (pfile.compare("") != 0) ? make_unique<profile>(sym) : nullptr;
+	// Execute
+	auto t0 = chrono::steady_clock::now();
+	try {
+		if (prof) runProfiled(*m, max, *prof);
+		else if (engine.compare("basic") == 0) run(*m, max);
+		else if (engine.compare("threaded") == 0) {
+			unique_ptr<pdcache> dc = make_unique<pdcache>();
+			runThreaded(*m, max, *dc);
+		} else {
+			unique_ptr<jit> j = make_unique<jit>();
+			j->check = check;
+			j->execute(*m, max);
+		}
+	} catch (exception &e) {
+		cerr << "Error: " << e.what() << nl;
+		return -1;
+	}
+	double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	// Print output register values
+	for (uint16_t v : m->out) {
+		if (dec) cout << v << nl;
+		else cout << bin2hex(v) << nl;
+	}
+	if (prof) {
+		ofs pf(pfile);
+		if (!pf) { cerr << "Cannot write '" << pfile << "'." << nl; return -1; }
+		writeFolded(pf, *prof);
+		writeSummary(cerr, *prof);
+	}
+	if (stats) cerr << "Microops: " << m->cyc << nl << "Time: " << fixed << setprecision(6) << secs << " s" << nl << "Speed: " << setprecision(1) << (secs > 0 ? m->cyc / secs / 1e6 : 0) << " Mops/s" << nl;
+	if (wfile.compare("") != 0) {
+		ofs sf(wfile, ios::binary);
+		if (!sf) { cerr << "Cannot write '" << wfile << "'." << nl; return -1; }
+		writeSnap(sf, save(*m));
+		return 0;
+	}
+	if (!m->hlt) { cerr << "Microop limit reached before HLT." << nl; return 1; }
+	return 0;
+}
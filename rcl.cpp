@@ -0,0 +1,117 @@
+/**
+ * =================
+ * RCL - RC16 LINKER
+ * =================
+ *
+ * MAIN
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#include <iomanip>
+#include <map>
+#include "src/main.hpp"
+#include "src/microops.cpp"
+#include "src/emulator.cpp"
+#include "src/synth.cpp"
+#include "src/isa.cpp"
+#include "src/peephole.cpp"
+#include "src/lexer.cpp"
+#include "src/expr.cpp"
+#include "src/runtime.cpp"
+#include "src/parser.cpp"
+#include "src/object.cpp"
+#include "src/image.cpp"
+#include "src/listing.cpp"
+
+// Prints usage help.
+// @return		String with usage help.
+string help() {
+	oss os;
+	os << "Usage: rcl [options] <file>.rco ..." << nl <<
+	"Objects are laid out in the given order: the program starts from the code of the first one." << nl <<
+	"Options:" << nl <<
+	" -i <arg>	Object file to be linked. May be repeated." << nl <<
+	" -o <arg>	Output file name. Default: 'a.bin'." << nl <<
+	" -O		Remove redundant microops from the program." << nl <<
+	" -f <arg>	Image format: raw (Logisim 'v2.0 raw'), flat (128kB little-endian memory dump) or seg (segmented). Default: raw." << nl <<
+	" -g		Also write the symbols of the program ('<file>.sym' next to its image), for profiling by rce." << nl <<
+	" -l		Also write the listing of the program ('<file>.lst' next to its image)." << nl <<
+	" -h		Print this help.";
+	return os.str();
+}
+
+// Main.
+int main(int argc, char* argv[]) {
+	vector<string> ifiles;
+	string ofile = "a.bin";
+	bool optimize = false;
+	uint8_t fmt = img_raw;
+	bool sym = false, lst = false;
+	// Parse command line options
+	int opt;
+	while ((opt = getopt(argc, argv, "i:o:Of:glh")) != -1) {
+		switch (opt) {
+			case 'i':
+				ifiles.pb(string(optarg));
+				break;
+			case 'o':
+				ofile = string(optarg);
+				break;
+			case 'O':
+				optimize = true;
+				break;
+			case 'f':
+				try {
+					fmt = imgFormat(string(optarg));
+				} catch (invalid_argument &e) {
+					cerr << e.what() << nl;
+					return -1;
+				}
+				break;
+			case 'g':
+				sym = true;
+				break;
+			case 'l':
+				lst = true;
+				break;
+			case 'h':
+				cout << help() << nl;
+				return 0;
+			default:
+				cerr << help() << nl;
+				return -1;
+		}
+	}
+	for (int i = optind; i < argc; ++i) ifiles.pb(string(argv[i]));
+	if (ifiles.empty()) { cerr << "No input file given." << nl; return -1; }
+	// Read objects
+	vector<object> objs;
+	for (const string &f : ifiles) {
+		try {
+			objs.pb(readObj(f));
+		} catch (invalid_argument &e) {
+			cerr << f << ": " << e.what() << nl;
+			return 1;
+		}
+	}
+	// Link them, with the runtime library they need
+	autolink(objs, cerr);
+	program prg = link(objs, cerr, optimize);
+	if (prg.errors > 0) return 1;
+	ofs bin(ofile, ios::binary);
+	if (!bin) { cerr << "Cannot write '" << ofile << "'." << nl; return 1; }
+	writeImg(bin, prg, fmt);
+	bin.close();
+	if (sym) {
+		ofs sf(binName(ofile, ".sym"));
+		if (!sf) { cerr << "Cannot write '" << binName(ofile, ".sym") << "'." << nl; return 1; }
+		writeSym(sf, prg);
+	}
+	if (lst) {
+		ofs lf(binName(ofile, ".lst"));
+		if (!lf) { cerr << "Cannot write '" << binName(ofile, ".lst") << "'." << nl; return 1; }
+		writeLst(lf, prg);
+	}
+	return 0;
+}
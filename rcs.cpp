@@ -0,0 +1,129 @@
+/**
+ * ===========================
+ * RCS - RC16 CIRCUIT SIMULATOR
+ * ===========================
+ *
+ * MAIN
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <functional>
+#include <cstring>
+#include "src/main.hpp"
+#include "src/emulator.cpp"
+#include "src/circuit.cpp"
+#include "src/gatesim.cpp"
+
+// Prints usage help.
+// @return		String with usage help.
+string help() {
+	oss os;
+	os << "Usage: rcs [options]" << nl <<
+	"Options:" << nl <<
+	" -i <arg>	Image file to be loaded into the RAM of the circuit [REQUIRED]." << nl <<
+	" -c <arg>	Logisim circuit of the machine. Default: 'main.circ'." << nl <<
+	" -n <arg>	Maximum number of clock cycles to simulate. Default: unlimited." << nl <<
+	" -d		Print output register values in decimal instead of hexadecimal." << nl <<
+	" -s		Print simulation statistics." << nl <<
+	" -x		Check the outputs and the number of microops against the emulator." << nl <<
+	" -v		Print the ports of the circuit which are not connected." << nl <<
+	" -h		Print this help.";
+	return os.str();
+}
+
+// Main.
+int main(int argc, char* argv[]) {
+	string ifile = "", cfile = "main.circ";
+	uint64_t max = UINT64_MAX;
+	bool dec = false, stats = false, check = false, verbose = false;
+	// Parse command line options
+	int opt;
+	while ((opt = getopt(argc, argv, "i:c:n:dsxvh")) != -1) {
+		switch (opt) {
+			case 'i':
+				ifile = string(optarg);
+				break;
+			case 'c':
+				cfile = string(optarg);
+				break;
+			case 'n':
+				max = stoull(optarg);
+				break;
+			case 'd':
+				dec = true;
+				break;
+			case 's':
+				stats = true;
+				break;
+			case 'x':
+				check = true;
+				break;
+			case 'v':
+				verbose = true;
+				break;
+			case 'h':
+				cout << help() << nl;
+				return 0;
+			default:
+				cerr << help() << nl;
+				return -1;
+		}
+	}
+	if (ifile.compare("") == 0) { cerr << "No image file given." << nl; return -1; }
+	rc16 *m = new rc16();
+	gsim *s;
+	lproj p;
+	netlist net;
+	auto t0 = chrono::steady_clock::now();
+	try {
+		loadImg(*m, ifile);
+		p = readCirc(cfile);
+		flatten(p, p.circ.at(p.main), "", net);
+		s = new gsim(net);
+		if (s->mem.empty()) throw invalid_argument("The circuit has no RAM.");
+		for (size_t i = 0; i < s->mem[0].size() && i <= mem_end; ++i) s->mem[0][i] = m->mem[i];
+	} catch (exception &e) {
+		cerr << "Error: " << e.what() << nl;
+		return -1;
+	}
+	if (verbose) for (const string &w : net.warn) cerr << "Warning: " << w << nl;
+	double csecs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	// Simulate
+	t0 = chrono::steady_clock::now();
+	try {
+		boot(*s);
+		runSim(*s, max);
+	} catch (exception &e) {
+		cerr << "Error: " << e.what() << nl;
+		return -1;
+	}
+	double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	uint64_t uops = (s->ir >= 0) ? s->seq[s->ir].n : 0;
+	// Print output register values
+	for (uint16_t v : s->out) {
+		if (dec) cout << v << nl;
+		else cout << bin2hex(v) << nl;
+	}
+	if (stats) cerr << "Components: " << s->ops.size() + s->seq.size() << " (" << s->V.size() << " words)" << nl << "Compilation time: " << fixed << setprecision(6) << csecs << " s" << nl
+					<< "Clock cycles: " << s->cyc << nl << "Microops: " << uops << nl << "Time: " << secs << " s" << nl
+					<< "Speed: " << setprecision(1) << (secs > 0 ? s->cyc / secs / 1e3 : 0) << " kHz" << nl;
+	if (check) {
+		run(*m, uops);
+		if (m->out != s->out || m->cyc != uops || m->hlt != s->halted) {
+			size_t i = 0;
+			while (i < m->out.size() && i < s->out.size() && m->out[i] == s->out[i]) ++i;
+			cerr << "Mismatch with the emulator: ";
+			if (i < m->out.size() || i < s->out.size()) cerr << "output " << i << " is " << (i < s->out.size() ? bin2hex(s->out[i]) : "missing") << " instead of " << (i < m->out.size() ? bin2hex(m->out[i]) : "missing") << nl;
+			else cerr << m->cyc << " microops executed instead of " << uops << (m->hlt ? " (halted)" : "") << nl;
+			return 1;
+		}
+		cerr << "Matches the emulator (" << uops << " microops)." << nl;
+	}
+	if (!s->halted) { cerr << "Clock cycle limit reached before HLT." << nl; return 1; }
+	return 0;
+}
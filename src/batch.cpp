@@ -0,0 +1,225 @@
+/**
+ * ===================
+ * RCE - RC16 EMULATOR
+ * ===================
+ *
+ * BATCH EMULATOR
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef BAT
+#define BAT
+
+#define bat_w           16 // Instances per group (lanes of a vector)
+
+// One 16-bit value per lane (GCC vector extensions; aligned for AVX2 loads, see 'runGroup').
+typedef uint16_t lanes __attribute__((vector_size(2 * bat_w), aligned(2 * bat_w)));
+typedef int16_t slanes __attribute__((vector_size(2 * bat_w), aligned(2 * bat_w)));
+typedef uint64_t quads __attribute__((vector_size(2 * bat_w), aligned(2 * bat_w)));
+
+// State of a group of instances, structure-of-arrays: every register is a vector holding it for each instance.
+struct blk {
+    lanes r[16] = {}; // Register file (see 'rc16')
+    lanes flg = {}; // Flags register
+    lanes live = {}; // 0xffff for instances which are running
+    lanes hlt = {}; // 0xffff for instances which have halted
+};
+
+// Many RC16 machines running the same program on their own data, in lockstep groups of 'bat_w'.
+// Every microop is fetched and decoded once per group, then executed on the instances whose PC points to it: when PCs
+// diverge, the instances at the lowest PC run first, while the others wait for them to catch up.
+// Memory is paged: instances share the pages of the loaded image, and copy a page the first time they write to it.
+struct batch {
+    size_t n; // Number of instances
+    vector<blk> g; // Groups
+    vector<uint16_t> img; // Shared memory image
+    vector<array<uint16_t*,pg_count>> pt; // Page table of every instance
+    deque<array<uint16_t,pg_words>> priv; // Private pages
+    array<bool,pg_count> dirty = {}; // Page has been copied by some instance
+    vector<vector<uint16_t>> out; // Values written to the output register, by instance
+    vector<uint64_t> cyc; // Executed microops, by instance
+    uint64_t cyc0; // Microops executed by the machine the instances started from
+
+    // Start instances from the state of a machine, including its outputs and executed microops so far.
+    // @param m     Machine (with its image loaded).
+    // @param n     Number of instances.
+    batch(const rc16 &m, const size_t n) : n(n), g((n + bat_w - 1) / bat_w), img(m.mem, m.mem + mem_end + 1), pt(g.size() * bat_w), out(n, m.out), cyc(g.size() * bat_w, 0), cyc0(m.cyc) {
+        fill(cyc.begin(), cyc.begin() + n, m.cyc);
+        for (size_t l = 0; l < pt.size(); ++l) for (size_t p = 0; p < pg_count; ++p) pt[l][p] = img.data() + (p << pg_bits);
+        for (size_t k = 0; k < g.size(); ++k) {
+            for (int i = 0; i < 16; ++i) g[k].r[i] += m.r[i];
+            g[k].flg += m.flg;
+            for (size_t i = 0; i < bat_w; ++i) g[k].live[i] = (k * bat_w + i < n && !m.hlt) ? 0xffff : 0;
+            if (m.hlt) g[k].hlt = ~g[k].hlt;
+        }
+    }
+    // Read a word of the memory of an instance.
+    uint16_t rd(const size_t l, const uint16_t a) const { return pt[l][a >> pg_bits][a & (pg_words - 1)]; }
+    // Write a word into the memory of an instance.
+    void wr(const size_t l, const uint16_t a, const uint16_t v) {
+        uint16_t *&p = pt[l][a >> pg_bits];
+        if (p == img.data() + ((a >> pg_bits) << pg_bits)) { // Shared: copy it
+            priv.emplace_back();
+            copy(p, p + pg_words, priv.back().begin());
+            p = priv.back().data();
+            dirty[a >> pg_bits] = true;
+        }
+        p[a & (pg_words - 1)] = v;
+    }
+    // Value of a register of an instance.
+    uint16_t &reg(const size_t l, const uint8_t r) { return g[l / bat_w].r[r][l % bat_w]; }
+    // Check whether an instance has halted.
+    bool halted(const size_t l) const { return g[l / bat_w].hlt[l % bat_w]; }
+};
+
+// Compute an ALU operation on every lane, as 'alu' does.
+// @param a         Inputs A.
+// @param nb        Inputs B.
+// @param op        ALU op-code.
+// @param notb      '~B' flag.
+// @param o         ALU outputs (output).
+// @param f         Flags computed by the operation (output).
+inline void valu(const lanes &a, const lanes &nb, const uint8_t op, const bool notb, lanes &o, lanes &f) {
+    lanes b = notb ? ~nb : nb;
+    lanes s = a + b, sum = s + (uint16_t)notb;
+    lanes cy = (((a & b) | ((a | b) & ~s)) >> 15) | ((lanes)(s == 0xffff) & (uint16_t)notb); // Carry out of the adder (no unsigned compares)
+    switch (op) {
+        case ADD: o = sum; break;
+        case AND: o = a & b; break;
+        case ORR: o = a | b; break;
+        case EOR: o = a ^ b; break;
+        case NOT: o = ~a; break;
+        default: { // LSL, LSR, ASR: one shift by a constant per bit of the amount (vectors only have those)
+            o = a;
+            for (int k = 0; k < 4; ++k) {
+                lanes t = (op == LSL) ? (lanes)(o << (1 << k)) : (op == LSR) ? (lanes)(o >> (1 << k)) : (lanes)((slanes)o >> (1 << k));
+                lanes bm = -((b >> k) & 0x1);
+                o = (o & ~bm) | (t & bm);
+            }
+            break;
+        }
+    }
+    f = (o >> 15) | ((lanes)(o == 0) & flg_z) | (cy << 2) | ((((~(a ^ b)) & (a ^ o)) >> 15) << 3);
+}
+
+// Check a condition on every lane: bit 'flg' of its mask, looked up by halving the mask once per flag bit (vectors only
+// have shifts by a constant).
+// @param msk       Condition mask (see 'cnd_mask').
+// @param flg       Flags registers.
+// @param em        Lanes to keep: cleared where the condition is not met (output).
+inline void vcnd(const uint16_t msk, const lanes &flg, lanes &em) {
+    lanes x = (lanes){} + msk;
+    x = (x & ~-((flg >> 3) & 0x1)) | ((x >> 8) & -((flg >> 3) & 0x1));
+    x = (x & ~-((flg >> 2) & 0x1)) | ((x >> 4) & -((flg >> 2) & 0x1));
+    x = (x & ~-((flg >> 1) & 0x1)) | ((x >> 2) & -((flg >> 1) & 0x1));
+    x = (x & ~-(flg & 0x1)) | ((x >> 1) & -(flg & 0x1));
+    em &= -(x & 0x1);
+}
+
+// Run a group until all of its instances halt or run out of their microop budget.
+// @param bt        Batch.
+// @param k         Group.
+// @param max       Limit on the microops executed by each instance, counting those before the batch started.
+// Compiled twice, for AVX2 (a group fits in one register) and for plain x86-64, and picked at load time.
+__attribute__((target_clones("avx2", "default"))) void runGroup(batch &bt, const size_t k, const uint64_t max) {
+    blk &s = bt.g[k];
+    const size_t l0 = k * bat_w;
+    uint64_t *cyc = &bt.cyc[l0];
+    auto sel = [](lanes &x, const lanes &v, const lanes &m) { x = (x & ~m) | (v & m); };
+    auto none = [](const lanes &x) {
+        quads q = (quads)x;
+        uint64_t a = 0;
+        for (size_t i = 0; i < bat_w / 4; ++i) a |= q[i];
+        return a == 0;
+    };
+    size_t lead = bat_w; // An instance at the PC being executed (bat_w: to be found)
+    lanes cnt = {}; // Executed microops since the last budget check
+    for (uint64_t steps = 0;; --steps) {
+        if (steps == 0) { // Budget: run as many microops as the instance closest to its limit has left
+            for (size_t i = 0; i < bat_w; ++i) {
+                cyc[i] += cnt[i];
+                if (cyc[i] >= max) s.live[i] = 0;
+            }
+            cnt = (lanes){};
+            steps = 0x7fff; // Within the range of 'cnt'
+            for (size_t i = 0; i < bat_w; ++i) if (s.live[i]) steps = min(steps, max - cyc[i]);
+            lead = bat_w;
+        }
+        uint16_t pc = (lead < bat_w) ? s.r[PC][lead] : 0;
+        lanes m = (lanes)(s.r[PC] == pc) & s.live;
+        if (lead == bat_w || !none(m ^ s.live)) { // PCs diverge: lowest one first
+            if (none(s.live)) break;
+            lanes t = (s.r[PC] & s.live) | ~s.live;
+            pc = 0xffff;
+            lead = bat_w;
+            for (size_t i = 0; i < bat_w; ++i) if (s.live[i] && (lead == bat_w || t[i] < pc)) { pc = t[i]; lead = i; }
+            m = (lanes)(s.r[PC] == pc) & s.live;
+        }
+        uint16_t instr = bt.rd(l0 + lead, pc);
+        if (bt.dirty[pc >> pg_bits]) for (size_t i = 0; i < bat_w; ++i) if (m[i] && bt.rd(l0 + i, pc) != instr) m[i] = 0; // Code was modified
+        cnt -= m;
+        s.r[PC] -= m; // PC + 1
+        if (!(instr & 0x8000) && (instr & 0x1)) { // LJR
+            sel(s.r[JR], (lanes){} + (uint16_t)(mem_iprg + ((instr >> 1) & 0x3fff)), m);
+            continue;
+        }
+        lanes em = m; // Condition met
+        if ((instr >> 10) & 0xf) vcnd(cnd_mask[(instr >> 10) & 0xf], s.flg, em);
+        switch (instr >> 14) {
+            case 0x0: // NOP, HLT
+                if (instr & 0x200) {
+                    s.r[PC] += em & 0x1; // Stay on the HLT
+                    s.live &= ~em;
+                    s.hlt |= em;
+                    lead = bat_w;
+                }
+                break;
+            case 0x1: {
+                if (!(instr & 0x200)) { // MOV (reg->reg)
+                    uint8_t d = dst_slot[(instr >> 1) & 0xf];
+                    sel(s.r[d], s.r[src_slot[(instr >> 5) & 0xf]], em);
+                    if (d == OR) for (size_t i = 0; i < bat_w; ++i) if (em[i]) bt.out[l0 + i].pb(s.r[OR][i]);
+                } else if (instr & 0x100) { // MOV (reg->mem)
+                    uint8_t r = src_slot[(instr >> 4) & 0xf];
+                    for (size_t i = 0; i < bat_w; ++i) if (em[i]) bt.wr(l0 + i, s.r[MAR][i], s.r[r][i]);
+                } else { // MOV (mem->reg)
+                    uint8_t d = dst_slot[(instr >> 4) & 0xf];
+                    for (size_t i = 0; i < bat_w; ++i) if (em[i]) {
+                        s.r[d][i] = bt.rd(l0 + i, s.r[MAR][i]);
+                        if (d == OR) bt.out[l0 + i].pb(s.r[OR][i]);
+                    }
+                }
+                break;
+            }
+            case 0x2: { // SET
+                uint8_t d = dst_slot[(instr >> 6) & 0xf];
+                sel(s.r[d], (lanes){} + (uint16_t)(instr & 0x3f), em);
+                if (d == OR) for (size_t i = 0; i < bat_w; ++i) if (em[i]) bt.out[l0 + i].pb(s.r[OR][i]);
+                break;
+            }
+            case 0x3: { // EXC
+                lanes o, f;
+                valu(s.r[A], s.r[B], (instr >> 7) & 0x7, instr & 0x40, o, f);
+                sel(s.r[OUT], o, em);
+                if (instr & 0x20) sel(s.flg, f, em);
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i < bat_w; ++i) cyc[i] += cnt[i];
+}
+
+// Run every instance of a batch until it halts or runs out of its microop budget.
+// @param bt        Batch.
+// @param max       Maximum number of microops executed by each instance, since the batch started.
+// @return          Number of microops executed, over all instances (including those before the batch started).
+inline uint64_t runBatch(batch &bt, const uint64_t max) {
+    const uint64_t lim = (max > UINT64_MAX - bt.cyc0) ? UINT64_MAX : bt.cyc0 + max;
+    for (size_t k = 0; k < bt.g.size(); ++k) runGroup(bt, k, lim);
+    uint64_t n = 0;
+    for (uint64_t c : bt.cyc) n += c;
+    return n;
+}
+
+#endif
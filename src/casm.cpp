@@ -0,0 +1,122 @@
+/**
+ * ===================
+ * RCC - RC16 COMPILER
+ * ===================
+ *
+ * COMPILE-TIME ASSEMBLER
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef CASM
+#define CASM
+
+// Programs can be assembled while C++ code is compiled, so that they can be embedded as constant arrays:
+//   constexpr const char *src = ".prgm\n put: r0, 1000\n prt: r0\n hlt\n";
+//   constexpr auto code = casm<casmlen(src)>(src);
+// Any error in the program (unknown instructions, invalid registers, immediates out of range, ...) is a compile error.
+// PUT sequences are built without the synthesis table (see 'putshift'), so they are longer than those of rcc.
+
+// Labels addresses: a list searched linearly, with the interface of the map used at run time.
+struct lblmap {
+    vector<pair<string,uint16_t>> v;
+
+    constexpr vector<pair<string,uint16_t>>::iterator end() { return v.end(); }
+    constexpr vector<pair<string,uint16_t>>::iterator find(const string &k) {
+        for (auto it = v.begin(); it != v.end(); ++it) if (it->first == k) return it;
+        return v.end();
+    }
+    constexpr uint16_t &operator[](const string &k) {
+        auto it = find(k);
+        if (it != v.end()) return it->second;
+        v.pb({ k, 0 });
+        return v.back().second;
+    }
+};
+
+// Program assembled at compile time (its buffers cannot outlive the evaluation: see 'casm' and 'casmdat').
+struct cprogram {
+    vector<uint16_t> dat; // Data section, from 'mem_idat' onwards
+    vector<uint16_t> code; // Code segment, from 'mem_iprg' onwards
+};
+
+// Assemble a program, like 'parsePrg' does, without optimizations.
+// @param src       Program text.
+// @return          Assembled program.
+constexpr cprogram casmv(const string_view src) {
+    cprogram out;
+    vector<uint16_t> &code = out.code;
+    lblmap d_lbl, p_lbl;
+    vector<fixup> fix;
+    int sec = 0; // Program section: 0 -> none, 1 -> data, 2 -> prgm
+    for (const token &t : lex(src)) {
+        const string_view line = t.s;
+        if (ieq(line, ".data")) { sec = 1; continue; } // Start of data section
+        else if (ieq(line, ".prgm")) { sec = 2; continue; } // Start of prgm section
+        if (sec == 1) { // Write data
+            vector<string_view> values;
+            if (line[0] == '&') { // If there is a label on this line
+                vector<string_view> s = split(line, '=');
+                d_lbl[lc(s[0].substr(1))] = mem_idat + out.dat.size(); // Store label address
+                values = split(trim(s[1]), ',');
+            } else values = split(line, ',');
+            for (string_view q : values) out.dat.pb(cnum(trim(q), 10));
+        } else if (sec == 2) {
+            if (line[0] == '&') p_lbl[lc(line.substr(1))] = mem_iprg + code.size(); // Store label address
+            else {
+                size_t f0 = fix.size();
+                parseLine(line, d_lbl, p_lbl, regvals(), code, fix);
+                for (size_t i = f0; i < fix.size(); ++i) fix[i].line = t.line;
+            }
+        }
+    }
+    if (mem_idat + out.dat.size() > mem_iprg) throw out_of_range("Data section exceeds ~32KB.");
+    // Patch fixups
+    for (const fixup &f : fix) {
+        if (f.kind == fix_ljr) {
+            code[f.at] = LJR(fixval(f.lbl, lblval(p_lbl)) - mem_iprg);
+            continue;
+        }
+        uint16_t val = fixval(f.lbl, [&](const string_view l) -> int64_t { return (d_lbl.find(string(l)) != d_lbl.end()) ? d_lbl[string(l)] : lblval(p_lbl)(l); });
+        vector<uint16_t> seq;
+        putfixed(seq, f.r, val, f.c);
+        copy(seq.begin(), seq.end(), code.begin() + f.at);
+    }
+    return out;
+}
+
+// Size of the code segment of a program.
+// @param src       Program text.
+// @return          Number of microops.
+constexpr size_t casmlen(const string_view src) { return casmv(src).code.size(); }
+
+// Size of the data section of a program.
+// @param src       Program text.
+// @return          Number of words.
+constexpr size_t casmdatlen(const string_view src) { return casmv(src).dat.size(); }
+
+// Assemble the code segment of a program.
+// @param src       Program text.
+// @return          Microops, from 'mem_iprg' onwards (N must be 'casmlen(src)').
+template <size_t N>
+constexpr array<uint16_t,N> casm(const string_view src) {
+    cprogram p = casmv(src);
+    if (p.code.size() != N) throw length_error("Code segment size differs from the array size.");
+    array<uint16_t,N> a = {};
+    copy(p.code.begin(), p.code.end(), a.begin());
+    return a;
+}
+
+// Assemble the data section of a program.
+// @param src       Program text.
+// @return          Words, from 'mem_idat' onwards (N must be 'casmdatlen(src)').
+template <size_t N>
+constexpr array<uint16_t,N> casmdat(const string_view src) {
+    cprogram p = casmv(src);
+    if (p.dat.size() != N) throw length_error("Data section size differs from the array size.");
+    array<uint16_t,N> a = {};
+    copy(p.dat.begin(), p.dat.end(), a.begin());
+    return a;
+}
+
+#endif
@@ -0,0 +1,476 @@
+/**
+ * ===========================
+ * RCS - RC16 CIRCUIT SIMULATOR
+ * ===========================
+ *
+ * LOGISIM CIRCUITS
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef CIRC
+#define CIRC
+
+// Logisim 2.7 project files are read as they are: components are only connected through the coordinates of their
+// ports and of wire ends, so the geometry of every component kind used by 'main.circ' is reproduced here (east being
+// the default facing). Wrong geometry shows up as width mismatches or as ports left unconnected ('-v').
+
+typedef pair<int,int> loc;
+
+// XML element (enough of XML for Logisim project files).
+struct xel {
+    string tag;
+    map<string,string> at; // Attributes
+    string text; // Text content
+    vector<xel> kids; // Child elements
+};
+
+// Replace the predefined entities of a piece of XML text.
+// @param s         Text.
+// @return          Decoded text.
+inline string xmlText(const string &s) {
+    static const pair<const char*,char> ent[] = { { "&lt;", '<' }, { "&gt;", '>' }, { "&quot;", '"' }, { "&apos;", '\'' }, { "&amp;", '&' } };
+    string r = "";
+    for (size_t i = 0; i < s.length(); ++i) {
+        bool found = false;
+        if (s[i] == '&') for (auto &e : ent) if (s.compare(i, strlen(e.first), e.first) == 0) {
+            r += e.second;
+            i += strlen(e.first) - 1;
+            found = true;
+            break;
+        }
+        if (!found) r += s[i];
+    }
+    return r;
+}
+
+// Read an XML file.
+// @param file      File name.
+// @return          Document (its elements are the children of an element with no tag).
+inline xel readXml(const string &file) {
+    ifs in(file);
+    if (!in) throw invalid_argument("Given circuit file does not exist or is unaccessible.");
+    oss ss;
+    ss << in.rdbuf();
+    const string s = ss.str();
+    xel doc;
+    vector<xel*> open = { &doc };
+    size_t i = 0;
+    while (i < s.length()) {
+        size_t lt = s.find('<', i);
+        if (lt == string::npos) break;
+        open.back()->text += xmlText(s.substr(i, lt - i));
+        if (s.compare(lt, 4, "<!--") == 0) { // Comment
+            size_t e = s.find("-->", lt);
+            i = (e == string::npos) ? s.length() : e + 3;
+            continue;
+        }
+        size_t gt = lt;
+        for (char q = 0; ++gt < s.length() && (q || s[gt] != '>');) if (s[gt] == '"' || s[gt] == '\'') q = (q == s[gt]) ? 0 : (q ? q : s[gt]);
+        if (gt >= s.length()) throw invalid_argument("Unterminated XML tag.");
+        string t = s.substr(lt + 1, gt - lt - 1);
+        i = gt + 1;
+        if (t[0] == '?' || t[0] == '!') continue; // Declaration
+        if (t[0] == '/') { // Closing tag
+            string ct = t.substr(1);
+            while (!ct.empty() && isspace(ct.back())) ct.pop_back();
+            if (open.size() == 1 || open.back()->tag.compare(ct) != 0) throw invalid_argument("Unbalanced XML tag '" + t + "'.");
+            open.pop_back();
+            continue;
+        }
+        bool empty = t.back() == '/';
+        if (empty) t.pop_back();
+        xel e;
+        size_t p = 0;
+        while (p < t.length() && !isspace(t[p])) ++p;
+        e.tag = t.substr(0, p);
+        while (true) { // Attributes
+            while (p < t.length() && isspace(t[p])) ++p;
+            if (p >= t.length()) break;
+            size_t eq = t.find('=', p);
+            if (eq == string::npos || eq + 1 >= t.length()) throw invalid_argument("Invalid XML attribute in '" + t + "'.");
+            char q = t[eq+1];
+            size_t end = t.find(q, eq + 2);
+            if (end == string::npos) throw invalid_argument("Invalid XML attribute in '" + t + "'.");
+            size_t ne = eq;
+            while (ne > p && isspace(t[ne-1])) --ne;
+            e.at[t.substr(p, ne - p)] = xmlText(t.substr(eq + 2, end - eq - 2));
+            p = end + 1;
+        }
+        open.back()->kids.pb(e);
+        if (!empty) open.pb(&open.back()->kids.back());
+    }
+    if (open.size() != 1) throw invalid_argument("Unterminated XML element '" + open.back()->tag + "'.");
+    return doc;
+}
+
+// Component of a circuit.
+struct lcomp {
+    int lib = -1; // Library (-1: a circuit of the project)
+    string name; // Component kind, or circuit name
+    loc at; // Location
+    map<string,string> a; // Attributes (only those which differ from the defaults are saved)
+};
+
+// Circuit of a project.
+struct lcirc {
+    string name;
+    vector<lcomp> comps;
+    vector<pair<loc,loc>> wires;
+    vector<pair<loc,loc>> ports; // Pins shown by instances: pin location, offset of the port from the instance location
+};
+
+// Logisim project.
+struct lproj {
+    map<string,lcirc> circ;
+    string main; // Top-level circuit
+};
+
+// Parse a point written as '(x,y)' or 'x,y'.
+// @param s         Point.
+// @return          Location.
+inline loc parseLoc(const string &s) {
+    int x, y;
+    if (sscanf(s.c_str(), "(%d,%d)", &x, &y) != 2 && sscanf(s.c_str(), "%d,%d", &x, &y) != 2) throw invalid_argument("Invalid location '" + s + "'.");
+    return { x, y };
+}
+
+// Read a Logisim project.
+// @param file      Project file name (.circ).
+// @return          Project.
+inline lproj readCirc(const string &file) {
+    xel doc = readXml(file);
+    if (doc.kids.size() != 1 || doc.kids[0].tag.compare("project") != 0) throw invalid_argument("Not a Logisim project.");
+    lproj p;
+    for (const xel &e : doc.kids[0].kids) {
+        if (e.tag.compare("main") == 0) p.main = e.at.at("name");
+        if (e.tag.compare("circuit") != 0) continue;
+        lcirc c;
+        c.name = e.at.at("name");
+        for (const xel &k : e.kids) {
+            if (k.tag.compare("wire") == 0) c.wires.pb({ parseLoc(k.at.at("from")), parseLoc(k.at.at("to")) });
+            else if (k.tag.compare("comp") == 0) {
+                lcomp m;
+                m.lib = k.at.count("lib") ? stoi(k.at.at("lib")) : -1;
+                m.name = k.at.at("name");
+                m.at = parseLoc(k.at.at("loc"));
+                for (const xel &a : k.kids) if (a.tag.compare("a") == 0) m.a[a.at.at("name")] = a.at.count("val") ? a.at.at("val") : a.text;
+                c.comps.pb(m);
+            } else if (k.tag.compare("appear") == 0) {
+                loc anchor = { 0, 0 };
+                vector<pair<loc,loc>> ps;
+                for (const xel &a : k.kids) {
+                    if (a.tag.compare("circ-anchor") != 0 && a.tag.compare("circ-port") != 0) continue;
+                    loc ctr = { stoi(a.at.at("x")) + stoi(a.at.at("width")) / 2, stoi(a.at.at("y")) + stoi(a.at.at("height")) / 2 };
+                    if (a.tag.compare("circ-anchor") == 0) anchor = ctr;
+                    else ps.pb({ parseLoc(a.at.at("pin")), ctr });
+                }
+                for (auto &q : ps) c.ports.pb({ q.first, { q.second.first - anchor.first, q.second.second - anchor.second } });
+            }
+        }
+        p.circ[c.name] = c;
+    }
+    if (p.circ.find(p.main) == p.circ.end()) throw invalid_argument("Main circuit '" + p.main + "' not found.");
+    return p;
+}
+
+// Attribute of a component.
+// @param c         Component.
+// @param name      Attribute name.
+// @param def       Default value.
+// @return          Attribute value.
+inline string attr(const lcomp &c, const string &name, const string &def) {
+    auto it = c.a.find(name);
+    return (it == c.a.end()) ? def : it->second;
+}
+
+// Numeric attribute of a component (decimal, or hexadecimal with '0x').
+// @param c         Component.
+// @param name      Attribute name.
+// @param def       Default value.
+// @return          Attribute value.
+inline uint64_t nattr(const lcomp &c, const string &name, const uint64_t def) {
+    auto it = c.a.find(name);
+    return (it == c.a.end()) ? def : stoull(it->second, nullptr, 0);
+}
+
+// End of a splitter which a bit of its combined side goes to. Logisim only leaves out the bits going to the end of
+// their own index.
+// @param c         Splitter.
+// @param b         Bit.
+// @param fan       Number of ends.
+// @return          End (-1: none).
+inline int splitEnd(const lcomp &c, const int b, const int fan) {
+    string v = attr(c, "bit" + to_string(b), "");
+    int e = v.empty() ? b : (v.compare("none") == 0) ? -1 : stoi(v);
+    return (e < fan) ? e : -1;
+}
+
+// Port of a component.
+struct cport {
+    loc d; // Offset from the component location
+    int w; // Width
+    bool out; // Driven by the component
+};
+
+// Ports of a component, in the order Logisim numbers them. Components with no effect on the machine (text, displays,
+// buttons...) have none.
+// @param p         Project.
+// @param c         Component.
+// @return          Ports.
+inline vector<cport> ports(const lproj &p, const lcomp &c) {
+    const string &n = c.name, face = attr(c, "facing", "east");
+    int w = nattr(c, "width", 1);
+    vector<cport> ps;
+    // Gates keep input 0 on the left or on top whatever their facing
+    auto gate = [&](const int dx, const int dy) -> loc {
+        if (face.compare("west") == 0) return { -dx, dy };
+        if (face.compare("north") == 0) return { dy, -dx };
+        if (face.compare("south") == 0) return { dy, dx };
+        return { dx, dy };
+    };
+    if (c.lib == -1) { // Circuit
+        auto it = p.circ.find(n);
+        if (it == p.circ.end()) throw invalid_argument("Unknown circuit '" + n + "'.");
+        for (auto &q : it->second.ports) {
+            const lcomp *pin = nullptr;
+            for (const lcomp &k : it->second.comps) if (k.lib == 0 && k.name.compare("Pin") == 0 && k.at == q.first) pin = &k;
+            if (!pin) throw invalid_argument("No pin at the port of circuit '" + n + "'.");
+            ps.pb({ q.second, (int)nattr(*pin, "width", 1), attr(*pin, "output", "false").compare("true") == 0 });
+        }
+    } else if (n.compare("Pin") == 0) ps.pb({ { 0, 0 }, w, attr(c, "output", "false").compare("false") == 0 });
+    else if (n.compare("Tunnel") == 0) ps.pb({ { 0, 0 }, w, false });
+    else if (n.compare("Constant") == 0) ps.pb({ { 0, 0 }, w, true });
+    else if (n.compare("Clock") == 0) ps.pb({ { 0, 0 }, 1, true });
+    else if (n.compare("Splitter") == 0) {
+        int fan = nattr(c, "fanout", 2), bits = nattr(c, "incoming", 2);
+        string app = attr(c, "appear", "left");
+        int just = (app.compare("center") == 0 || app.compare("legacy") == 0) ? 0 : (app.compare("right") == 0) ? 1 : -1;
+        vector<int> ew(fan, 0); // Width of every end
+        for (int b = 0; b < bits; ++b) {
+            int e = splitEnd(c, b, fan);
+            if (e >= 0) ++ew[e];
+        }
+        int x0, y0, dx, dy;
+        if (face.compare("north") == 0 || face.compare("south") == 0) {
+            int m = face.compare("north") == 0 ? 1 : -1;
+            x0 = (just == 0) ? 10 * ((fan + 1) / 2 - 1) : (m * just < 0) ? -10 : 10 * fan;
+            y0 = -m * 20;
+            dx = -10;
+            dy = 0;
+        } else {
+            int m = face.compare("west") == 0 ? -1 : 1;
+            x0 = m * 20;
+            y0 = (just == 0) ? -10 * (fan / 2) : (m * just > 0) ? 10 : -10 * fan;
+            dx = 0;
+            dy = 10;
+        }
+        ps.pb({ { 0, 0 }, bits, false });
+        for (int e = 0; e < fan; ++e) ps.pb({ { x0 + e * dx, y0 + e * dy }, ew[e], false });
+    } else if (n.compare("Bit Extender") == 0) {
+        ps.pb({ { 0, 0 }, (int)nattr(c, "out_width", 16), true });
+        ps.pb({ { -40, 0 }, (int)nattr(c, "in_width", 8), false });
+        if (attr(c, "type", "zero").compare("input") == 0) ps.pb({ { -20, -20 }, 1, false });
+    } else if (n.compare("NOT Gate") == 0) {
+        ps.pb({ { 0, 0 }, w, true });
+        ps.pb({ gate(nattr(c, "size", 30) == 20 ? -20 : -30, 0), w, false });
+    } else if (n.compare("AND Gate") == 0 || n.compare("OR Gate") == 0 || n.compare("XOR Gate") == 0 || n.compare("XNOR Gate") == 0 ||
+               n.compare("NAND Gate") == 0 || n.compare("NOR Gate") == 0) {
+        int in = nattr(c, "inputs", 5), size = nattr(c, "size", 50);
+        int axis = size + ((n[0] == 'X') ? 10 : 0) + ((n[0] == 'N' || (n[0] == 'X' && n[1] == 'N')) ? 10 : 0); // Output bubble
+        int start, dist, lower;
+        if (in <= 3) {
+            if (size < 40) { start = -5; dist = 10; lower = 10; }
+            else if (size < 60 || in <= 2) { start = -10; dist = 20; lower = 20; }
+            else { start = -15; dist = 30; lower = 30; }
+        } else if (in == 4 && size >= 60) { start = -5; dist = 20; lower = 0; }
+        else { start = -5; dist = 10; lower = 10; }
+        ps.pb({ { 0, 0 }, w, true });
+        for (int i = 0; i < in; ++i) {
+            int dy = (in & 1) ? start * (in - 1) + dist * i : start * in + dist * i + ((i >= in / 2) ? lower : 0);
+            int dx = axis + (attr(c, "negate" + to_string(i), "false").compare("true") == 0 ? 10 : 0);
+            ps.pb({ gate(-dx, dy), w, false });
+        }
+    } else if (n.compare("Controlled Buffer") == 0 || n.compare("Controlled Inverter") == 0) {
+        int side = attr(c, "control", "right").compare("left") == 0 ? -10 : 10;
+        ps.pb({ { 0, 0 }, w, true });
+        ps.pb({ gate(-20, 0), w, false });
+        ps.pb({ gate(-10, side), 1, false });
+    } else if (n.compare("Multiplexer") == 0) {
+        int sel = nattr(c, "select", 1), in = 1 << sel, flip = attr(c, "selloc", "bl").compare("tr") == 0 ? -1 : 1;
+        if (face.compare("east") != 0) throw invalid_argument("Unsupported multiplexer facing '" + face + "'.");
+        for (int i = 0; i < in; ++i) ps.pb({ (in == 2) ? loc(-30, -10 + 20 * i) : loc(-40, -(in / 2) * 10 + 10 * i), w, false });
+        loc s = (in == 2) ? loc(-20, 20 * flip) : loc(-20, flip * (in / 2) * 10);
+        if (flip < 0 && in > 2) s.second -= 10;
+        ps.pb({ s, sel, false });
+        if (attr(c, "enable", "true").compare("true") == 0) ps.pb({ { s.first + 10, s.second }, 1, false });
+        ps.pb({ { 0, 0 }, w, true });
+    } else if (n.compare("Decoder") == 0) {
+        int sel = nattr(c, "select", 1), out = 1 << sel;
+        bool tr = attr(c, "selloc", "bl").compare("tr") == 0;
+        if (face.compare("east") != 0) throw invalid_argument("Unsupported decoder facing '" + face + "'.");
+        for (int i = 0; i < out; ++i) ps.pb({ (out == 2) ? loc(10, (tr ? 10 : -30) + 20 * i) : loc(20, (tr ? 0 : -10 * out) + 10 * i), 1, true });
+        ps.pb({ { 0, 0 }, sel, false });
+        if (attr(c, "enable", "true").compare("true") == 0) ps.pb({ { -10, 0 }, 1, false });
+    } else if (n.compare("Adder") == 0) {
+        ps.pb({ { -40, -10 }, w, false });
+        ps.pb({ { -40, 10 }, w, false });
+        ps.pb({ { 0, 0 }, w, true });
+        ps.pb({ { -20, -20 }, 1, false });
+        ps.pb({ { -20, 20 }, 1, true });
+    } else if (n.compare("Shifter") == 0) {
+        int sw = 0;
+        while ((1 << sw) < w) ++sw;
+        ps.pb({ { -40, -10 }, w, false });
+        ps.pb({ { -40, 10 }, sw, false });
+        ps.pb({ { 0, 0 }, w, true });
+    } else if (n.compare("Comparator") == 0) {
+        ps.pb({ { -40, -10 }, w, false });
+        ps.pb({ { -40, 10 }, w, false });
+        ps.pb({ { 0, -10 }, 1, true });
+        ps.pb({ { 0, 0 }, 1, true });
+        ps.pb({ { 0, 10 }, 1, true });
+    } else if (n.compare("Register") == 0) {
+        w = nattr(c, "width", 8);
+        ps.pb({ { 0, 0 }, w, true });
+        ps.pb({ { -30, 0 }, w, false });
+        ps.pb({ { -20, 20 }, 1, false });
+        ps.pb({ { -10, 20 }, 1, false });
+        ps.pb({ { -30, 10 }, 1, false });
+    } else if (n.compare("Counter") == 0) {
+        w = nattr(c, "width", 8);
+        ps.pb({ { 0, 0 }, w, true });
+        ps.pb({ { -30, 0 }, w, false });
+        ps.pb({ { -20, 20 }, 1, false });
+        ps.pb({ { -10, 20 }, 1, false });
+        ps.pb({ { -30, -10 }, 1, false });
+        ps.pb({ { -30, 10 }, 1, false });
+        ps.pb({ { 0, 10 }, 1, true });
+    } else if (n.compare("RAM") == 0) {
+        int aw = nattr(c, "addrWidth", 8), dw = nattr(c, "dataWidth", 8);
+        if (attr(c, "bus", "combined").compare("separate") != 0) throw invalid_argument("Only RAMs with separate load and store ports are supported.");
+        ps.pb({ { 0, 0 }, dw, true });
+        ps.pb({ { -140, 0 }, aw, false });
+        ps.pb({ { -90, 40 }, 1, false });
+        ps.pb({ { -50, 40 }, 1, false });
+        ps.pb({ { -30, 40 }, 1, false });
+        ps.pb({ { -70, 40 }, 1, false });
+        ps.pb({ { -110, 40 }, 1, false });
+        ps.pb({ { -140, 20 }, dw, false });
+    } else if (n.compare("Text") != 0 && n.compare("Hex Digit Display") != 0 && n.compare("Button") != 0 && n.compare("Probe") != 0 && n.compare("LED") != 0)
+        throw invalid_argument("Unsupported component '" + n + "'.");
+    return ps;
+}
+
+// Primitive component of a flattened circuit.
+struct prim {
+    const lcomp *c; // Component
+    string path; // Instance path ('/'-separated circuit instances, then the component label or kind)
+    vector<vector<uint32_t>> bits; // Nets of every bit of every port (see 'ports')
+    vector<bool> out; // Port is an output
+};
+
+// Circuit flattened into primitive components and nets of one bit. Splitters, tunnels, pins of inner circuits and wires
+// only join bits, so they leave no component behind.
+struct netlist {
+    vector<uint32_t> uf; // Union-find forest of bits
+    vector<prim> prims;
+    map<string,vector<uint32_t>> names; // Tunnels and pins, by path
+    vector<string> warn; // Ports connected to nothing
+
+    // New bits.
+    vector<uint32_t> alloc(const int w) {
+        vector<uint32_t> b(w);
+        for (int i = 0; i < w; ++i) { b[i] = uf.size(); uf.pb(uf.size()); }
+        return b;
+    }
+    // Net of a bit.
+    uint32_t find(uint32_t b) {
+        while (uf[b] != b) b = uf[b] = uf[uf[b]];
+        return b;
+    }
+    // Join two bits.
+    void join(const uint32_t a, const uint32_t b) { uf[find(a)] = find(b); }
+};
+
+// Flatten an instance of a circuit into a netlist.
+// @param p         Project.
+// @param c         Circuit.
+// @param path      Instance path ("" for the top-level circuit).
+// @param nl        Netlist (output).
+// @return          Bits of every pin, by location.
+inline map<loc,vector<uint32_t>> flatten(const lproj &p, const lcirc &c, const string &path, netlist &nl) {
+    string where = " in circuit '" + c.name + "'";
+    // Wires join points
+    map<loc,loc> pf;
+    function<loc(loc)> root = [&](loc l) {
+        auto it = pf.find(l);
+        if (it == pf.end()) { pf[l] = l; return l; }
+        if (it->second == l) return l;
+        return it->second = root(it->second);
+    };
+    set<loc> wired;
+    for (auto &w : c.wires) {
+        pf[root(w.first)] = root(w.second);
+        wired.insert(w.first);
+        wired.insert(w.second);
+    }
+    // Ports join nets
+    vector<vector<cport>> cps(c.comps.size());
+    map<loc,vector<pair<size_t,size_t>>> at; // Ports at every net
+    for (size_t i = 0; i < c.comps.size(); ++i) {
+        cps[i] = ports(p, c.comps[i]);
+        for (size_t j = 0; j < cps[i].size(); ++j) at[root({ c.comps[i].at.first + cps[i][j].d.first, c.comps[i].at.second + cps[i][j].d.second })].pb({ i, j });
+    }
+    vector<vector<vector<uint32_t>>> bits(c.comps.size());
+    for (size_t i = 0; i < c.comps.size(); ++i) bits[i].resize(cps[i].size());
+    for (auto &n : at) {
+        int w = cps[n.second[0].first][n.second[0].second].w;
+        for (auto &q : n.second) if (cps[q.first][q.second].w != w) {
+            const lcomp &a = c.comps[n.second[0].first], &b = c.comps[q.first];
+            throw invalid_argument("Width mismatch between " + a.name + " (" + to_string(a.at.first) + "," + to_string(a.at.second) + ") and " + b.name +
+                                   " (" + to_string(b.at.first) + "," + to_string(b.at.second) + ") at (" + to_string(n.first.first) + "," + to_string(n.first.second) + ")" + where + ".");
+        }
+        vector<uint32_t> b = nl.alloc(w);
+        for (auto &q : n.second) bits[q.first][q.second] = b;
+        if (n.second.size() == 1 && !wired.count(n.first)) {
+            const lcomp &k = c.comps[n.second[0].first];
+            nl.warn.pb("Port " + to_string(n.second[0].second) + " of " + k.name + " (" + to_string(k.at.first) + "," + to_string(k.at.second) + ")" + where + " is not connected.");
+        }
+    }
+    // Tunnels, splitters and inner circuits join bits
+    map<string,vector<uint32_t>> tun;
+    map<loc,vector<uint32_t>> pins;
+    for (size_t i = 0; i < c.comps.size(); ++i) {
+        const lcomp &k = c.comps[i];
+        string label = attr(k, "label", "");
+        vector<bool> dirs;
+        for (const cport &q : cps[i]) dirs.pb(q.out);
+        if (k.lib == -1) {
+            string sub = path + (path.empty() ? "" : "/") + (label.empty() ? k.name : label);
+            map<loc,vector<uint32_t>> in = flatten(p, p.circ.at(k.name), sub, nl);
+            const vector<pair<loc,loc>> &cp = p.circ.at(k.name).ports;
+            for (size_t j = 0; j < cp.size(); ++j) for (size_t b = 0; b < bits[i][j].size(); ++b) nl.join(bits[i][j][b], in.at(cp[j].first)[b]);
+        } else if (k.name.compare("Tunnel") == 0) {
+            auto it = tun.find(label);
+            if (it == tun.end()) tun[label] = bits[i][0];
+            else if (it->second.size() != bits[i][0].size()) throw invalid_argument("Width mismatch of tunnel '" + label + "'" + where + ".");
+            else for (size_t b = 0; b < bits[i][0].size(); ++b) nl.join(bits[i][0][b], it->second[b]);
+            nl.names[path + "/" + label] = bits[i][0];
+        } else if (k.name.compare("Splitter") == 0) {
+            vector<size_t> used(bits[i].size(), 0);
+            int fan = bits[i].size() - 1, in = bits[i][0].size();
+            for (int b = 0; b < in; ++b) {
+                int e = splitEnd(k, b, fan);
+                if (e >= 0) nl.join(bits[i][0][b], bits[i][e+1][used[e+1]++]);
+            }
+        } else if (k.name.compare("Pin") == 0) {
+            pins[k.at] = bits[i][0];
+            nl.names[path + "/" + label] = bits[i][0];
+            if (path.empty()) nl.prims.pb({ &k, path + "/" + label, bits[i], dirs }); // Inputs and outputs of the machine
+        } else if (!bits[i].empty()) nl.prims.pb({ &k, path + "/" + (label.empty() ? k.name + " (" + to_string(k.at.first) + "," + to_string(k.at.second) + ")" : label), bits[i], dirs });
+    }
+    return pins;
+}
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * ===================
+ * RCE - RC16 EMULATOR
+ * ===================
+ *
+ * MACHINE STATE & INTERPRETER
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef EMU
+#define EMU
+
+// ALU flags, in the order the ALU drives them ('V C Z S', S being bit 0)
+#define flg_s           0x1 // Sign
+#define flg_z           0x2 // Zero
+#define flg_c           0x4 // Carry out of the adder
+#define flg_v           0x8 // Overflow
+
+// Register file slots which are not real registers
+#define r_sink          0xe // Destination of writes to registers that have no input enable
+#define r_zero          0xf // Source of reads from registers that have no output enable
+
+// Memory pages, the unit memory is shared and copied in by batch instances, and stored in by snapshots
+#define pg_bits         8 // Page size: 256 words
+#define pg_words        (1 << pg_bits)
+#define pg_count        ((mem_end + 1) >> pg_bits)
+
+// RC16 machine state.
+struct rc16 {
+    uint16_t r[16] = {}; // Register file, indexed by 'reg' (R0..R7, A, B, OUT, MAR, OR, JR)
+    uint8_t flg = 0; // Flags register
+    bool hlt = false; // Halted
+    uint64_t cyc = 0; // Executed microops
+    vector<uint16_t> out; // Values written to the output register, in order
+    uint16_t mem[mem_end+1] = {}; // Main memory (128kB)
+};
+
+// Evaluate a condition code against every possible value of the flags register.
+// Mirrors the condition multiplexer of the control unit: LT and GT only look at S, and codes above CC are never true.
+// @param c         Condition code.
+// @return          Mask with bit 'f' set if the condition holds when the flags register contains 'f'.
+constexpr uint16_t condmask(const uint8_t c) {
+    uint16_t m = 0x0;
+    for (uint8_t f = 0x0; f <= 0xf; ++f) {
+        bool s = f & flg_s, z = f & flg_z, cy = f & flg_c, v = f & flg_v, t = false;
+        switch (c) {
+            case AL: t = true; break;
+            case EQ: t = z; break;
+            case NE: t = !z; break;
+            case LT: t = s; break;
+            case LE: t = s || z; break;
+            case GT: t = !s; break;
+            case GE: t = !s || z; break;
+            case VS: t = v; break;
+            case VC: t = !v; break;
+            case CS: t = cy; break;
+            case CC: t = !cy; break;
+        }
+        if (t) m |= 1 << f;
+    }
+    return m;
+}
+
+// Condition masks, indexed by condition code.
+constexpr uint16_t cnd_mask[16] = {
+    condmask(0x0), condmask(0x1), condmask(0x2), condmask(0x3), condmask(0x4), condmask(0x5), condmask(0x6), condmask(0x7),
+    condmask(0x8), condmask(0x9), condmask(0xa), condmask(0xb), condmask(0xc), condmask(0xd), condmask(0xe), condmask(0xf)
+};
+
+// Register file slot read by a microop that names a source register (only R0..R7, OUT and JR drive the bus).
+constexpr uint8_t src_slot[16] = { R0, R1, R2, R3, R4, R5, R6, R7, r_zero, r_zero, OUT, r_zero, r_zero, JR, r_zero, r_zero };
+
+// Register file slot written by a microop that names a destination register (only R0..R7, A, B, MAR and OR latch the bus).
+constexpr uint8_t dst_slot[16] = { R0, R1, R2, R3, R4, R5, R6, R7, A, B, r_sink, MAR, OR, r_sink, r_sink, r_sink };
+
+// Compute an ALU operation, exactly as the 'alu' circuit does.
+// @param a         Input A.
+// @param b         Input B.
+// @param op        ALU op-code.
+// @param notb      '~B' flag: B is complemented and the adder carry-in is set.
+// @param f         Flags computed by the operation (output).
+// @return          ALU output.
+inline uint16_t alu(const uint16_t a, uint16_t b, const uint8_t op, const bool notb, uint8_t &f) {
+    if (notb) b = ~b;
+    uint32_t sum = (uint32_t)a + b + notb;
+    uint16_t o;
+    switch (op) {
+        case ADD: o = sum; break;
+        case AND: o = a & b; break;
+        case ORR: o = a | b; break;
+        case EOR: o = a ^ b; break;
+        case NOT: o = ~a; break;
+        case LSL: o = a << (b & 0xf); break;
+        case LSR: o = a >> (b & 0xf); break;
+        default: o = (int16_t)a >> (b & 0xf); break; // ASR
+    }
+    // Carry and overflow come from the adder whatever the op-code, as in hardware
+    f = (o >> 15) | ((o == 0) << 1) | (((sum >> 16) & 0x1) << 2) | ((((~(a ^ b)) & (a ^ o)) >> 15) << 3);
+    return o;
+}
+
+// Write a value into a register file slot, recording writes to the output register.
+// @param m         Machine.
+// @param slot      Register file slot (see 'dst_slot').
+// @param val       Value.
+inline void wreg(rc16 &m, const uint8_t slot, const uint16_t val) {
+    m.r[slot] = val;
+    if (slot == OR) m.out.pb(val);
+}
+
+// Execute a microop (the program counter already points past it).
+// @param m         Machine.
+// @param instr     Microop.
+// @return          False if the microop halted the machine, true otherwise.
+inline bool exec(rc16 &m, const uint16_t instr) {
+    if (!(instr & 0x8000) && (instr & 0x1)) { // LJR = 0b0.xxxxxxxxxxxxxx.1
+        m.r[JR] = mem_iprg + ((instr >> 1) & 0x3fff);
+        return true;
+    }
+    if (!((cnd_mask[(instr >> 10) & 0xf] >> m.flg) & 0x1)) return true; // Condition not met
+    switch (instr >> 14) {
+        case 0x0: // NOP = 0b00.xxxx.0.000000000, HLT = 0b00.xxxx.1.000000000
+            if (instr & 0x200) {
+                m.hlt = true;
+                --m.r[PC]; // Stay on the HLT
+                return false;
+            }
+            break;
+        case 0x1:
+            if (!(instr & 0x200)) wreg(m, dst_slot[(instr >> 1) & 0xf], m.r[src_slot[(instr >> 5) & 0xf]]); // MOV (reg->reg)
+            else if (instr & 0x100) m.mem[m.r[MAR]] = m.r[src_slot[(instr >> 4) & 0xf]]; // MOV (reg->mem)
+            else wreg(m, dst_slot[(instr >> 4) & 0xf], m.mem[m.r[MAR]]); // MOV (mem->reg)
+            break;
+        case 0x2: // SET
+            wreg(m, dst_slot[(instr >> 6) & 0xf], instr & 0x3f);
+            break;
+        case 0x3: { // EXC
+            uint8_t f;
+            m.r[OUT] = alu(m.r[A], m.r[B], (instr >> 7) & 0x7, instr & 0x40, f);
+            if (instr & 0x20) m.flg = f;
+            break;
+        }
+    }
+    return true;
+}
+
+// Execute a single microop.
+// @param m         Machine.
+inline void step(rc16 &m) {
+    if (m.hlt) return;
+    ++m.cyc;
+    exec(m, m.mem[m.r[PC]++]);
+}
+
+// Run the machine until it halts or a microop budget runs out.
+// @param m         Machine.
+// @param max       Maximum number of microops to execute.
+// @return          Number of microops executed.
+inline uint64_t run(rc16 &m, const uint64_t max) {
+    if (m.hlt) return 0;
+    uint64_t n = 0;
+    while (n < max) {
+        ++n;
+        if (!exec(m, m.mem[m.r[PC]++])) break;
+    }
+    m.cyc += n;
+    return n;
+}
+
+// Read little-endian words straight into memory.
+// @param img       Image stream.
+// @param w         Destination.
+// @param n         Number of words.
+// @return          True if every word was read.
+inline bool readLe(istream &img, uint16_t *w, const size_t n) {
+    if (!img.read((char*)w, 2 * n)) return false;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (size_t i = 0; i < n; ++i) w[i] = (w[i] >> 8) | (w[i] << 8);
+#endif
+    return true;
+}
+
+// Load a memory image (as written by rcc) into memory: a Logisim 'v2.0 raw' image, a flat 128kB dump of the whole
+// memory or a segmented image. Binary images are read straight into memory, without parsing.
+// @param m         Machine.
+// @param file      Image file name.
+inline void loadImg(rc16 &m, const string &file) {
+    ifs img(file, ios::binary);
+    if (!img) throw invalid_argument("Given image does not exist or is unaccessible.");
+    char magic[8] = {};
+    img.read(magic, 8);
+    img.clear();
+    img.seekg(0, ios::end);
+    size_t size = img.tellg();
+    img.seekg(0);
+    bool seg = string(magic, 4).compare("RC16") == 0, raw = string(magic, 8).compare("v2.0 raw") == 0;
+    if (size == sizeof(m.mem) && !seg && !raw) { // Flat (a text image of the same size still has its header)
+        if (!readLe(img, m.mem, mem_end + 1)) throw invalid_argument("Truncated image.");
+        return;
+    }
+    if (seg) { // Segmented
+        img.seekg(8);
+        uint16_t n = (uint8_t)magic[6] | ((uint8_t)magic[7] << 8); // Segments
+        for (uint16_t s = 0; s < n; ++s) {
+            uint16_t h[6]; // Region, base address, region size, stored words
+            if (!readLe(img, h, 6)) throw invalid_argument("Truncated image.");
+            uint32_t len = h[4] | ((uint32_t)h[5] << 16);
+            if ((uint32_t)h[1] + len > mem_end + 1) throw out_of_range("Image exceeds memory size.");
+            if (!readLe(img, m.mem + h[1], len)) throw invalid_argument("Truncated image.");
+        }
+        return;
+    }
+    string line;
+    if (!getline(img, line) || line.compare(0, 8, "v2.0 raw") != 0) throw invalid_argument("Not a 'v2.0 raw' image.");
+    uint32_t ptr = mem_init;
+    while (getline(img, line)) {
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash); // Strip comments
+        iss ls(line);
+        string tok;
+        while (ls >> tok) {
+            uint32_t n = 1; // Run length
+            size_t star = tok.find('*');
+            try {
+                if (star != string::npos) {
+                    n = stoul(tok.substr(0, star));
+                    tok = tok.substr(star+1);
+                }
+                size_t end;
+                unsigned long val = stoul(tok, &end, 16);
+                if (end != tok.length() || val > 0xffff) throw invalid_argument(tok);
+                if (ptr + n > mem_end + 1) throw out_of_range("Image exceeds memory size.");
+                fill(m.mem + ptr, m.mem + ptr + n, (uint16_t)val);
+                ptr += n;
+            } catch (invalid_argument &e) {
+                throw invalid_argument("Malformed image word '" + tok + "'.");
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ * ===================
+ * RCC - RC16 COMPILER
+ * ===================
+ *
+ * CONSTANT EXPRESSIONS
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef EXP
+#define EXP
+
+// Characters which make an operand an expression, rather than a single number or label.
+constexpr string_view exp_ops = "+-*/%&|^~<>()";
+
+// Check whether an operand is an expression: it has an operator, other than a leading sign.
+// @param s         Operand.
+// @return          True if it is an expression.
+constexpr bool isexpr(const string_view s) {
+    if (s.empty()) return false;
+    if (s[0] == '(' || s[0] == '~') return true;
+    return s.find_first_of(exp_ops, 1) != string_view::npos;
+}
+
+// Length of the name of a label, in an expression.
+// @param s         Text following the '$'.
+// @return          Number of characters of the name.
+constexpr size_t lbllen(const string_view s) {
+    size_t n = 0;
+    while (n < s.length() && s[n] != ' ' && s[n] != ',' && exp_ops.find(s[n]) == string_view::npos) ++n;
+    return n;
+}
+
+// Evaluator of constant expressions, by recursive descent. Operators bind like in C: unary '-', '+' and '~' first, then
+// '*', '/' and '%', '+' and '-', '<<' and '>>', '&', '^' and '|' last. Operands are numbers (decimal, or hexadecimal
+// with '0x'), labels ('$<name>', whose value is given by a function) and expressions in parentheses.
+template <class lookup>
+struct expreval {
+    const string_view s; // Expression
+    const lookup &lbl; // Label values (by name, as written)
+    size_t i = 0; // Next character
+
+    constexpr expreval(const string_view s, const lookup &lbl) : s(s), lbl(lbl) {}
+
+    [[noreturn]] constexpr void fail() const { throw invalid_argument("Invalid expression '" + string(s) + "'."); }
+    // Skip spaces, and check whether an operator follows.
+    constexpr bool at(const string_view op) {
+        while (i < s.length() && s[i] == ' ') ++i;
+        return s.substr(i, op.length()) == op;
+    }
+    constexpr int64_t atom() {
+        if (at("(")) {
+            ++i;
+            int64_t v = orr();
+            if (!at(")")) fail();
+            ++i;
+            return v;
+        }
+        if (at("-")) { ++i; return -atom(); }
+        if (at("+")) { ++i; return atom(); }
+        if (at("~")) { ++i; return ~atom(); }
+        if (i >= s.length()) fail();
+        if (s[i] == '$') { // Label
+            size_t n = lbllen(s.substr(i + 1));
+            if (n == 0) fail();
+            int64_t v = lbl(s.substr(i + 1, n));
+            i += n + 1;
+            return v;
+        }
+        size_t n = 0; // Length of the number (or name)
+        while (i + n < s.length() && ((s[i+n] >= '0' && s[i+n] <= '9') || (s[i+n] >= 'a' && s[i+n] <= 'z') || (s[i+n] >= 'A' && s[i+n] <= 'Z') || s[i+n] == '_')) ++n;
+        string_view t = s.substr(i, n);
+        if (n == 0) fail();
+        if (!(t[0] >= '0' && t[0] <= '9')) throw invalid_argument("Unknown constant '" + string(t) + "'.");
+        int base = (n > 2 && t[0] == '0' && (t[1] == 'x' || t[1] == 'X')) ? 16 : 10;
+        int64_t v = 0;
+        for (size_t k = (base == 16) ? 2 : 0; k < n; ++k) {
+            char l = (t[k] >= 'A' && t[k] <= 'Z') ? t[k] - 'A' + 'a' : t[k];
+            int d = (l >= '0' && l <= '9') ? l - '0' : (l >= 'a' && l <= 'f') ? l - 'a' + 10 : base;
+            if (d >= base) fail();
+            v = (v * base + d) & 0xffffffff;
+        }
+        i += n;
+        return v;
+    }
+    constexpr int64_t mul() {
+        int64_t v = atom();
+        for (;;) {
+            if (at("*")) { ++i; v *= atom(); }
+            else if (at("/") || at("%")) {
+                bool div = s[i++] == '/';
+                int64_t r = atom();
+                if (r == 0) throw invalid_argument("Division by zero.");
+                v = div ? v / r : v % r;
+            } else return v;
+            v = (int32_t)v; // Keep values from overflowing
+        }
+    }
+    constexpr int64_t add() {
+        int64_t v = mul();
+        for (;;) {
+            if (at("+")) { ++i; v += mul(); }
+            else if (at("-")) { ++i; v -= mul(); }
+            else return v;
+            v = (int32_t)v;
+        }
+    }
+    constexpr int64_t shift() {
+        int64_t v = add();
+        for (;;) {
+            if (at("<<")) { i += 2; int64_t r = add(); v = (r < 0 || r > 31) ? 0 : (int32_t)((uint32_t)v << r); }
+            else if (at(">>")) { i += 2; int64_t r = add(); v = (r < 0 || r > 31) ? (v < 0 ? -1 : 0) : v >> r; }
+            else return v;
+        }
+    }
+    constexpr int64_t _and() {
+        int64_t v = shift();
+        while (at("&")) { ++i; v &= shift(); }
+        return v;
+    }
+    constexpr int64_t eor() {
+        int64_t v = _and();
+        while (at("^")) { ++i; v ^= _and(); }
+        return v;
+    }
+    constexpr int64_t orr() {
+        int64_t v = eor();
+        while (at("|")) { ++i; v |= eor(); }
+        return v;
+    }
+};
+
+// Evaluate a constant expression. Values are 32-bit, and are truncated to 16 bits where they are used.
+// @param s         Expression.
+// @param lbl       Function giving the value of a label from its name (as written), throwing if it is not known.
+// @return          Value.
+template <class lookup>
+constexpr int64_t eval(const string_view s, const lookup &lbl) {
+    expreval<lookup> e(s, lbl);
+    int64_t v = e.orr();
+    if (e.at("") && e.i < s.length()) e.fail(); // Trailing characters
+    return v;
+}
+
+#endif
@@ -0,0 +1,508 @@
+/**
+ * ===========================
+ * RCS - RC16 CIRCUIT SIMULATOR
+ * ===========================
+ *
+ * GATE-LEVEL SIMULATOR
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef GSIM
+#define GSIM
+
+// The flattened circuit is compiled once into a schedule of word-level operations. Every output port of a component
+// owns a field of a 64-bit word, and every input port is gathered from the words of its nets by a few shift-and-mask
+// terms, one per run of bits laid out in the same order. Combinational components are sorted by level and only run
+// when some bit they read has changed, so that the circuit settles in a single pass through the schedule (or in a
+// few, through its combinational loops, if any).
+// Registers, counters and RAMs latch on the rising edges of their clock inputs, wherever these come from.
+// Values have two levels: floating nets read 0, buses driven by many tristate buffers read the OR of the enabled ones,
+// gate inputs left unconnected are ignored (as Logisim does by default), and enable inputs left unconnected are on.
+// Input pins of the top-level circuit are held high (the power switch of 'main.circ').
+
+#define gs_clock        "/Clock" // Clock of the machine
+#define gs_out          "cpu/OR/" // Output register (instance)
+#define gs_ir           "cpu/IR/" // Instruction register (instance): loaded once per microop
+#define gs_hlt          "cpu/hlt" // Halt signal (tunnel)
+#define gs_settle       1000 // Maximum number of passes for the circuit to settle
+
+// Kinds of operations
+enum gkind : uint8_t { G_MERGE, G_AND, G_OR, G_XOR, G_NAND, G_NOR, G_XNOR, G_NOT, G_BUF, G_INV, G_MUX, G_DEC, G_ADD, G_SHL, G_LSR, G_ASR, G_CMP, G_EXT, G_RAM, G_REG, G_CNT };
+
+// Term of an input: ((V[w] >> s) & m) << d.
+struct gterm {
+    uint32_t w;
+    uint8_t s, d;
+    uint64_t m;
+};
+
+// Input of an operation: OR of its terms.
+typedef vector<gterm> gath;
+
+// Field of a word written by an operation.
+struct gfield {
+    uint32_t w; // Word
+    uint8_t o; // Offset
+    uint64_t m; // Mask of the width
+};
+
+// Combinational operation.
+struct gop {
+    gkind k;
+    vector<gath> in; // Inputs, in the order of the ports of the component (see 'ports')
+    vector<gfield> out; // Outputs
+    uint64_t m = 0; // Mask of the data width
+    uint64_t x = 0; // Negated inputs (gates), inputs (multiplexers), type (bit extenders, comparators) or RAM
+};
+
+// Sequential component.
+struct gseq {
+    gkind k; // G_REG, G_CNT or G_RAM
+    string path;
+    gath ck, clr, en, ld, d, a, cs; // Clock, clear, enable (count, store), load, data, address and chip select
+    gfield q; // State (registers and counters)
+    uint64_t x = 0; // Maximum value (counters) or RAM
+    bool fall = false; // Triggered by falling edges
+    bool last = false; // Clock input when last checked
+    uint64_t n = 0; // Number of loads
+};
+
+// Compiled circuit.
+struct gsim {
+    vector<uint64_t> V = { 0x0, ~0x0ull }; // Words (the first two are constants)
+    vector<gop> ops; // Combinational schedule
+    size_t loop; // First operation of the schedule which depends on a combinational loop
+    vector<vector<pair<uint32_t,uint64_t>>> rdr; // Operations reading every word (then sequential components, reading
+                                                 // their clock and clear inputs), and the bits they read
+    vector<uint8_t> dirty; // Operation has to run again, or sequential component has to be checked again
+    vector<gseq> seq; // Sequential components
+    vector<vector<uint64_t>> mem; // RAM contents
+    vector<uint32_t> ramop; // Operation reading every RAM
+    gfield clk = { 0, 0, 0x0 }; // Clock
+    gath hlt; // Halt signal
+    int orr = -1, ir = -1; // Output and instruction registers (in 'seq')
+    bool halted = false;
+    uint64_t cyc = 0; // Clock cycles
+    vector<uint16_t> out; // Values loaded into the output register, in order
+    uint64_t outAt = UINT64_MAX; // Loads of the instruction register at the last output
+    vector<pair<gfield,uint64_t>> st; // Scratch space of 'latch'
+    vector<array<uint64_t,3>> stores;
+
+    // Compile a netlist.
+    // @param nl    Netlist.
+    gsim(netlist &nl);
+    // Read an input.
+    uint64_t rd(const gath &g) const {
+        uint64_t v = 0;
+        for (const gterm &t : g) v |= ((V[t.w] >> t.s) & t.m) << t.d;
+        return v;
+    }
+    // Write an output, and wake up the operations reading the bits it changed.
+    void wr(const gfield &f, const uint64_t v) {
+        uint64_t nv = (V[f.w] & ~(f.m << f.o)) | ((v & f.m) << f.o), ch = nv ^ V[f.w];
+        if (!ch) return;
+        V[f.w] = nv;
+        for (auto &r : rdr[f.w]) if (r.second & ch) dirty[r.first] = 1;
+    }
+};
+
+// Build an input from the locations of its bits, merging runs.
+// @param b         Word, bit and destination bit of every term of one bit.
+// @return          Input.
+inline gath gather(vector<array<uint32_t,3>> b) {
+    sort(b.begin(), b.end(), [](const array<uint32_t,3> &x, const array<uint32_t,3> &y) {
+        return make_tuple(x[0], x[1] - x[2], x[2]) < make_tuple(y[0], y[1] - y[2], y[2]);
+    });
+    gath g;
+    for (size_t i = 0; i < b.size(); ++i) {
+        if (!g.empty() && i > 0 && b[i][0] == b[i-1][0] && b[i][1] == b[i-1][1] + 1 && b[i][2] == b[i-1][2] + 1) {
+            g.back().m = (g.back().m << 1) | 0x1;
+            continue;
+        }
+        g.pb({ b[i][0], (uint8_t)b[i][1], (uint8_t)b[i][2], 0x1 });
+    }
+    return g;
+}
+
+// Execute a combinational operation.
+// @param s         Simulator.
+// @param op        Operation.
+inline void exec(gsim &s, const gop &op) {
+    switch (op.k) {
+        case G_MERGE: s.wr(op.out[0], s.rd(op.in[0])); break;
+        case G_AND: case G_OR: case G_XOR: case G_NAND: case G_NOR: case G_XNOR: {
+            if (op.in.empty()) { s.wr(op.out[0], 0); break; } // Floating
+            uint64_t one = 0, many = 0;
+            uint64_t v = (op.k == G_AND || op.k == G_NAND) ? ~0x0ull : 0x0;
+            for (size_t i = 0; i < op.in.size(); ++i) {
+                uint64_t a = s.rd(op.in[i]) ^ (((op.x >> i) & 0x1) ? ~0x0ull : 0x0);
+                if (op.k == G_AND || op.k == G_NAND) v &= a;
+                else if (op.k == G_OR || op.k == G_NOR) v |= a;
+                else {
+                    many |= one & a;
+                    one = (one | a) & ~many;
+                }
+            }
+            if (op.k == G_XOR || op.k == G_XNOR) v = one; // True when exactly one input is
+            s.wr(op.out[0], (op.k == G_NAND || op.k == G_NOR || op.k == G_XNOR) ? ~v : v);
+            break;
+        }
+        case G_NOT: s.wr(op.out[0], ~s.rd(op.in[0])); break;
+        case G_BUF: case G_INV: {
+            uint64_t v = s.rd(op.in[0]);
+            s.wr(op.out[0], !(s.rd(op.in[1]) & 0x1) ? 0x0 : (op.k == G_INV) ? ~v : v);
+            break;
+        }
+        case G_MUX: {
+            uint64_t sel = s.rd(op.in[op.x]);
+            s.wr(op.out[0], (op.in.size() > op.x + 1 && !(s.rd(op.in[op.x+1]) & 0x1)) ? 0x0 : s.rd(op.in[sel]));
+            break;
+        }
+        case G_DEC: {
+            uint64_t sel = s.rd(op.in[0]);
+            bool en = op.in.size() < 2 || (s.rd(op.in[1]) & 0x1);
+            for (size_t i = 0; i < op.out.size(); ++i) s.wr(op.out[i], en && i == sel);
+            break;
+        }
+        case G_ADD: {
+            uint64_t a = s.rd(op.in[0]), b = s.rd(op.in[1]), c = s.rd(op.in[2]) & 0x1, sum = a + b + c;
+            s.wr(op.out[0], sum);
+            s.wr(op.out[1], (op.m == ~0x0ull) ? (sum < a || (sum == a && c)) : (sum & ~op.m) != 0);
+            break;
+        }
+        case G_SHL: case G_LSR: case G_ASR: {
+            uint64_t a = s.rd(op.in[0]) & op.m, d = s.rd(op.in[1]);
+            int w = __builtin_popcountll(op.m);
+            uint64_t v = (d >= (uint64_t)w) ? 0x0 : (op.k == G_SHL) ? a << d : a >> d;
+            if (op.k == G_ASR && (a >> (w - 1)) & 0x1) v |= op.m & ~(op.m >> min<uint64_t>(d, w));
+            s.wr(op.out[0], v);
+            break;
+        }
+        case G_CMP: {
+            uint64_t a = s.rd(op.in[0]), b = s.rd(op.in[1]);
+            if (op.x) { // Two's complement: flip the sign bits
+                uint64_t sb = op.m & ~(op.m >> 1);
+                a ^= sb;
+                b ^= sb;
+            }
+            s.wr(op.out[0], a > b);
+            s.wr(op.out[1], a == b);
+            s.wr(op.out[2], a < b);
+            break;
+        }
+        case G_EXT: {
+            uint64_t a = s.rd(op.in[0]) & op.m, fill;
+            switch (op.x) {
+                case 0x1: fill = 0x1; break; // One
+                case 0x2: fill = (a & ~(op.m >> 1)) != 0; break; // Sign
+                case 0x3: fill = s.rd(op.in[1]) & 0x1; break; // Input
+                default: fill = 0x0; // Zero
+            }
+            s.wr(op.out[0], a | (fill ? ~op.m : 0x0));
+            break;
+        }
+        case G_CNT: {
+            uint64_t v = s.rd(op.in[0]);
+            bool ld = s.rd(op.in[2]) & 0x1;
+            s.wr(op.out[0], (s.rd(op.in[1]) & 0x1) && v == (ld ? 0x0 : op.x));
+            break;
+        }
+        case G_RAM: {
+            bool on = (s.rd(op.in[1]) & 0x1) && (s.rd(op.in[2]) & 0x1);
+            s.wr(op.out[0], on ? s.mem[op.x][s.rd(op.in[0])] : 0x0);
+            break;
+        }
+        default: break;
+    }
+}
+
+inline gsim::gsim(netlist &nl) {
+    // Outputs own fields of words
+    unordered_map<uint32_t,vector<pair<uint32_t,uint32_t>>> drv; // Bits driving every net
+    vector<vector<gfield>> of(nl.prims.size());
+    for (size_t i = 0; i < nl.prims.size(); ++i) {
+        const prim &p = nl.prims[i];
+        if (p.path.compare(0, 1, "/") == 0 && p.c->name.compare("Pin") == 0 && !p.out[0]) continue; // Output pin
+        uint32_t o = 64;
+        for (size_t j = 0; j < p.bits.size(); ++j) {
+            if (!p.out[j]) continue;
+            if (p.bits[j].size() > 64) throw invalid_argument("Port wider than 64 bits: " + p.path + ".");
+            if (o + p.bits[j].size() > 64) {
+                V.pb(0);
+                o = 0;
+            }
+            of[i].pb({ (uint32_t)V.size() - 1, (uint8_t)o, (p.bits[j].size() == 64) ? ~0x0ull : (0x1ull << p.bits[j].size()) - 1 });
+            for (size_t b = 0; b < p.bits[j].size(); ++b) drv[nl.find(p.bits[j][b])].pb({ V.size() - 1, o + b });
+            o += p.bits[j].size();
+        }
+    }
+    // Nets with many drivers read their OR, collected into a word for each word of their first driver
+    unordered_map<uint32_t,pair<uint32_t,uint32_t>> at; // Location of every driven net
+    map<uint32_t,vector<array<uint32_t,3>>> merge; // Terms of every merged word, by word of the first driver
+    for (auto &n : drv) {
+        if (n.second.size() == 1) { at[n.first] = n.second[0]; continue; }
+        sort(n.second.begin(), n.second.end());
+        for (auto &b : n.second) merge[n.second[0].first].pb({ b.first, b.second, n.second[0].second });
+    }
+    for (auto &m : merge) {
+        V.pb(0);
+        gop op = { G_MERGE, { gather(m.second) }, { { (uint32_t)V.size() - 1, 0, ~0x0ull } } };
+        ops.pb(op);
+        for (auto &n : drv) if (n.second.size() > 1 && n.second[0].first == m.first) at[n.first] = { V.size() - 1, n.second[0].second };
+    }
+    auto driven = [&](const vector<uint32_t> &bits) {
+        for (uint32_t b : bits) if (at.count(nl.find(b))) return true;
+        return false;
+    };
+    auto in = [&](const vector<uint32_t> &bits) {
+        vector<array<uint32_t,3>> t;
+        for (uint32_t b = 0; b < bits.size(); ++b) {
+            auto it = at.find(nl.find(bits[b]));
+            if (it != at.end()) t.pb({ it->second.first, it->second.second, b });
+        }
+        return gather(t);
+    };
+    auto on = [&](const vector<uint32_t> &bits) { return driven(bits) ? in(bits) : gath({ { 1, 0, 0, 0x1 } }); }; // Enables: on when unconnected
+    // Operations
+    for (size_t i = 0; i < nl.prims.size(); ++i) {
+        const prim &p = nl.prims[i];
+        const lcomp &c = *p.c;
+        const string &n = c.name;
+        const vector<vector<uint32_t>> &b = p.bits;
+        auto mask = [](const size_t w) { return (w == 64) ? ~0x0ull : (0x1ull << w) - 1; };
+        string trig = attr(c, "trigger", "rising");
+        if (trig.compare("rising") != 0 && trig.compare("falling") != 0) throw invalid_argument("Unsupported trigger '" + trig + "': " + p.path + ".");
+        gop op = { G_MERGE, {}, of[i], b.empty() ? 0x0 : mask(b[0].size()) };
+        if (n.compare("Pin") == 0) {
+            if (p.out[0]) V[of[i][0].w] |= of[i][0].m << of[i][0].o;
+            continue;
+        } else if (n.compare("Constant") == 0) {
+            V[of[i][0].w] |= (nattr(c, "value", 0x1) & of[i][0].m) << of[i][0].o;
+            continue;
+        } else if (n.compare("Clock") == 0) {
+            if (p.path.compare(gs_clock) == 0) clk = of[i][0];
+            continue;
+        } else if (n.compare("Register") == 0 || n.compare("Counter") == 0) {
+            bool reg = n.compare("Register") == 0;
+            gseq q = { reg ? G_REG : G_CNT, p.path, in(b[2]), in(b[3]), on(b[reg ? 4 : 5]), reg ? gath() : in(b[4]), in(b[1]), {}, {}, of[i][0] };
+            q.x = reg ? 0x0 : nattr(c, "max", mask(b[0].size()));
+            q.fall = trig.compare("falling") == 0;
+            if (reg && p.path.compare(0, strlen(gs_out), gs_out) == 0) orr = seq.size();
+            if (reg && p.path.compare(0, strlen(gs_ir), gs_ir) == 0) ir = seq.size();
+            seq.pb(q);
+            if (reg) continue;
+            if (attr(c, "ongoal", "wrap").compare("wrap") != 0) throw invalid_argument("Unsupported counter overflow '" + attr(c, "ongoal", "") + "': " + p.path + ".");
+            op.k = G_CNT; // Carry
+            op.in = { { { of[i][0].w, of[i][0].o, 0, of[i][0].m } }, q.en, q.ld };
+            op.out = { of[i][1] };
+            op.x = q.x;
+        } else if (n.compare("RAM") == 0) {
+            mem.pb(vector<uint64_t>(1ull << b[1].size(), 0));
+            gseq q = { G_RAM, p.path, in(b[5]), in(b[4]), on(b[6]), {}, in(b[7]), in(b[1]), on(b[2]), {} };
+            q.x = mem.size() - 1;
+            q.fall = trig.compare("falling") == 0;
+            seq.pb(q);
+            op.k = G_RAM;
+            op.in = { in(b[1]), on(b[2]), on(b[3]) };
+            op.x = mem.size() - 1;
+        } else if (n.compare("NOT Gate") == 0) {
+            op.k = G_NOT;
+            op.in = { in(b[1]) };
+        } else if (n.compare("Controlled Buffer") == 0 || n.compare("Controlled Inverter") == 0) {
+            op.k = (n[11] == 'B') ? G_BUF : G_INV;
+            op.in = { in(b[1]), on(b[2]) };
+        } else if (n.compare("Multiplexer") == 0) {
+            op.k = G_MUX;
+            op.x = 1 << nattr(c, "select", 1);
+            for (size_t j = 0; j + 1 < b.size(); ++j) op.in.pb((j == op.x + 1) ? on(b[j]) : in(b[j]));
+            op.m = mask(b.back().size());
+        } else if (n.compare("Decoder") == 0) {
+            op.k = G_DEC;
+            size_t outs = 1 << nattr(c, "select", 1);
+            op.in.pb(in(b[outs]));
+            if (b.size() > outs + 1) op.in.pb(on(b[outs+1]));
+        } else if (n.compare("Adder") == 0) {
+            op.k = G_ADD;
+            op.in = { in(b[0]), in(b[1]), in(b[3]) };
+        } else if (n.compare("Shifter") == 0) {
+            string sh = attr(c, "shift", "ll");
+            if (sh.compare("ll") != 0 && sh.compare("lr") != 0 && sh.compare("ar") != 0) throw invalid_argument("Unsupported shift '" + sh + "': " + p.path + ".");
+            op.k = (sh.compare("ll") == 0) ? G_SHL : (sh.compare("lr") == 0) ? G_LSR : G_ASR;
+            op.in = { in(b[0]), in(b[1]) };
+        } else if (n.compare("Comparator") == 0) {
+            op.k = G_CMP;
+            op.in = { in(b[0]), in(b[1]) };
+            op.x = attr(c, "mode", "twosComplement").compare("unsigned") != 0;
+        } else if (n.compare("Bit Extender") == 0) {
+            string t = attr(c, "type", "zero");
+            op.k = G_EXT;
+            op.in = { in(b[1]) };
+            if (b.size() > 2) op.in.pb(in(b[2]));
+            op.m = mask(b[1].size());
+            op.x = (t.compare("one") == 0) ? 0x1 : (t.compare("sign") == 0) ? 0x2 : (t.compare("input") == 0) ? 0x3 : 0x0;
+        } else { // Gates
+            static const map<string,gkind> gates = { { "AND Gate", G_AND }, { "OR Gate", G_OR }, { "XOR Gate", G_XOR }, { "NAND Gate", G_NAND }, { "NOR Gate", G_NOR }, { "XNOR Gate", G_XNOR } };
+            auto it = gates.find(n);
+            if (it == gates.end()) throw invalid_argument("Unsupported component '" + n + "': " + p.path + ".");
+            if (attr(c, "xor", "1").compare("odd") == 0) throw invalid_argument("Unsupported odd parity gate: " + p.path + ".");
+            op.k = it->second;
+            for (size_t j = 1; j < b.size(); ++j) {
+                if (!driven(b[j])) continue; // Ignored
+                if (attr(c, "negate" + to_string(j - 1), "false").compare("true") == 0) op.x |= 0x1ull << op.in.size();
+                op.in.pb(in(b[j]));
+            }
+        }
+        ops.pb(op);
+    }
+    if (clk.m == 0) throw invalid_argument("No clock labeled '" + string(gs_clock + 1) + "' in the top-level circuit.");
+    if (nl.names.count(gs_hlt)) hlt = in(nl.names.at(gs_hlt));
+    // Levels: every operation after those writing the bits it reads (Kahn's algorithm)
+    vector<vector<pair<size_t,uint64_t>>> writers(V.size());
+    vector<vector<size_t>> next(ops.size());
+    vector<size_t> deps(ops.size(), 0);
+    for (size_t i = 0; i < ops.size(); ++i) for (const gfield &f : ops[i].out) writers[f.w].pb({ i, f.m << f.o });
+    for (size_t i = 0; i < ops.size(); ++i) {
+        set<size_t> from;
+        for (const gath &g : ops[i].in) for (const gterm &t : g) for (auto &j : writers[t.w]) if (j.second & (t.m << t.s)) from.insert(j.first);
+        for (size_t j : from) {
+            next[j].pb(i);
+            ++deps[i];
+        }
+    }
+    vector<gop> sched;
+    vector<size_t> ready;
+    vector<bool> done(ops.size(), false);
+    for (size_t i = 0; i < ops.size(); ++i) if (deps[i] == 0) ready.pb(i);
+    for (size_t r = 0; r < ready.size(); ++r) {
+        sched.pb(ops[ready[r]]);
+        done[ready[r]] = true;
+        for (size_t j : next[ready[r]]) if (--deps[j] == 0) ready.pb(j);
+    }
+    loop = sched.size();
+    for (size_t i = 0; i < ops.size(); ++i) if (!done[i]) sched.pb(ops[i]);
+    ops = sched;
+    rdr.resize(V.size());
+    ramop.resize(mem.size());
+    for (size_t i = 0; i < ops.size(); ++i) {
+        for (const gath &g : ops[i].in) for (const gterm &t : g) {
+            if (rdr[t.w].empty() || rdr[t.w].back().first != i) rdr[t.w].pb({ i, 0x0 });
+            rdr[t.w].back().second |= t.m << t.s;
+        }
+        if (ops[i].k == G_RAM) ramop[ops[i].x] = i;
+    }
+    for (size_t i = 0; i < seq.size(); ++i) for (const gath *g : { &seq[i].ck, &seq[i].clr }) for (const gterm &t : *g) {
+        if (rdr[t.w].empty() || rdr[t.w].back().first != ops.size() + i) rdr[t.w].pb({ ops.size() + i, 0x0 });
+        rdr[t.w].back().second |= t.m << t.s;
+    }
+    dirty.assign(ops.size() + seq.size(), 1);
+}
+
+// Settle the combinational part of a circuit.
+// @param s         Simulator.
+inline void settle(gsim &s) {
+    for (size_t i = 0; i < s.loop; ++i) if (s.dirty[i]) {
+        s.dirty[i] = 0;
+        exec(s, s.ops[i]);
+    }
+    for (int k = 0;; ++k) { // Loops: until nothing changes
+        bool run = false;
+        for (size_t i = s.loop; i < s.ops.size(); ++i) if (s.dirty[i]) {
+            s.dirty[i] = 0;
+            exec(s, s.ops[i]);
+            run = true;
+        }
+        if (!run) break;
+        if (k == gs_settle) throw invalid_argument("The circuit does not settle.");
+    }
+}
+
+// Update the sequential components of a circuit whose clock or clear inputs changed: clear them, and latch those whose
+// clock rose, all of them sampling their inputs at once.
+// @param s         Simulator.
+// @return          True if any state changed.
+inline bool latch(gsim &s) {
+    vector<pair<gfield,uint64_t>> &st = s.st; // New states
+    vector<array<uint64_t,3>> &stores = s.stores; // RAM, address, value
+    st.clear();
+    stores.clear();
+    bool changed = false;
+    for (size_t i = 0; i < s.seq.size(); ++i) {
+        if (!s.dirty[s.ops.size() + i]) continue;
+        s.dirty[s.ops.size() + i] = 0;
+        gseq &q = s.seq[i];
+        bool ck = (s.rd(q.ck) & 0x1) != q.fall, edge = ck && !q.last;
+        q.last = ck;
+        bool clr = s.rd(q.clr) & 0x1;
+        if (q.k == G_RAM) {
+            vector<uint64_t> &m = s.mem[q.x];
+            if (clr && any_of(m.begin(), m.end(), [](const uint64_t v) { return v != 0; })) {
+                fill(m.begin(), m.end(), 0);
+                s.dirty[s.ramop[q.x]] = 1;
+                changed = true;
+            }
+            if (edge && !clr && (s.rd(q.cs) & 0x1) && (s.rd(q.en) & 0x1)) stores.pb({ q.x, s.rd(q.a), s.rd(q.d) });
+            continue;
+        }
+        uint64_t v = (s.V[q.q.w] >> q.q.o) & q.q.m, nv = v;
+        if (clr) nv = 0;
+        else if (edge && q.k == G_REG) {
+            if (s.rd(q.en) & 0x1) {
+                nv = s.rd(q.d) & q.q.m;
+                ++q.n;
+                if ((int)i == s.orr && (s.ir < 0 || s.seq[s.ir].n != s.outAt)) { // Once per microop: the register may stay enabled for many clock cycles
+                    s.out.pb(nv);
+                    s.outAt = (s.ir < 0) ? 0 : s.seq[s.ir].n;
+                }
+            }
+        } else if (edge) { // Counter: load, or count (down when loading too)
+            bool ld = s.rd(q.ld) & 0x1, ct = s.rd(q.en) & 0x1;
+            if (ct) nv = ld ? ((v == 0) ? q.x : v - 1) : ((v == q.x) ? 0 : v + 1);
+            else if (ld) nv = s.rd(q.d) & q.q.m;
+            ++q.n;
+        }
+        if (nv != v) st.pb({ q.q, nv });
+    }
+    for (auto &x : st) s.wr(x.first, x.second);
+    for (auto &x : stores) {
+        s.mem[x[0]][x[1]] = x[2];
+        s.dirty[s.ramop[x[0]]] = 1;
+    }
+    return changed || !st.empty() || !stores.empty();
+}
+
+// Let a circuit settle from its initial state (registers and counters at zero).
+// @param s         Simulator.
+inline void boot(gsim &s) {
+    settle(s);
+    for (gseq &q : s.seq) q.last = (s.rd(q.ck) & 0x1) != q.fall;
+    for (int k = 0; latch(s); ++k) {
+        if (k == gs_settle) throw invalid_argument("The circuit does not settle.");
+        settle(s);
+    }
+}
+
+// Toggle the clock of a circuit and let it settle, latching registers on the way.
+// @param s         Simulator.
+inline void tick(gsim &s) {
+    s.wr(s.clk, ~(s.V[s.clk.w] >> s.clk.o));
+    for (int k = 0;; ++k) {
+        if (k == gs_settle) throw invalid_argument("The circuit does not settle.");
+        settle(s);
+        if (!latch(s)) break;
+    }
+}
+
+// Run a circuit until its halt signal is high.
+// @param s         Simulator.
+// @param max       Maximum number of clock cycles.
+inline void runSim(gsim &s, const uint64_t max) {
+    while (!s.halted && s.cyc < max) {
+        tick(s);
+        tick(s);
+        ++s.cyc;
+        s.halted = s.rd(s.hlt) & 0x1;
+    }
+}
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * ===================
+ * RCC - RC16 COMPILER
+ * ===================
+ *
+ * MEMORY IMAGES
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef IMG
+#define IMG
+
+// Image formats
+#define img_raw     0x0 // Logisim 'v2.0 raw' text, repeated words run-length encoded
+#define img_flat    0x1 // Whole memory, 16-bit little-endian words (128kB, can be mapped as it is)
+#define img_seg     0x2 // Header and one segment per memory region (see below)
+
+// Segmented image format (every field little-endian):
+//   char[4] "RC16", uint16 version (1), uint16 number of segments
+//   per segment: uint16 region (seg_*), uint16 base address, uint32 region size, uint32 stored words, stored words
+// Memory past the stored words of a segment is zero.
+#define seg_dat     0x0 // Boot microops and data section, from 'mem_init'
+#define seg_prg     0x1 // Code segment, from 'mem_iprg'
+#define seg_stk     0x2 // Stack, from 'mem_istk' (never stored)
+
+// Image format by name.
+// @param name      Format name: raw, flat or seg.
+// @return          Image format.
+inline uint8_t imgFormat(const string &name) {
+    if (name.compare("raw") == 0) return img_raw;
+    if (name.compare("flat") == 0) return img_flat;
+    if (name.compare("seg") == 0) return img_seg;
+    throw invalid_argument("Unknown image format '" + name + "'.");
+}
+
+// Boot microops, at 'mem_init'.
+// @return          SP = mem_estk (0xffff), LR = mem_iprg (0x4000), PC = mem_iprg (0x4000).
+inline vector<uint16_t> bootSeq() {
+    return { SET(A, 0), EXC(NOT, false, false), MOVREG(OUT, SP),
+             SET(A, 32), SET(B, 9), EXC(LSL, false, false), MOVREG(OUT, LR),
+             MOVREG(OUT, PC) };
+}
+
+// Write 16-bit words as hexadecimal numbers, runs of a repeated word as '<count>*<word>'.
+// @param os        Output stream.
+// @param w         Words.
+inline void writeRle(ostream &os, const vector<uint16_t> &w) {
+    vector<uint16_t> lit; // Words written as they are
+    for (size_t i = 0, j; i < w.size(); i = j) {
+        for (j = i + 1; j < w.size() && w[j] == w[i]; ++j);
+        if (j - i == 1) { lit.pb(w[i]); continue; }
+        writeHex(os, lit);
+        lit.clear();
+        os << j - i << "*" << hex << w[i] << dec << " ";
+    }
+    writeHex(os, lit);
+}
+
+// Write little-endian words.
+// @param os        Output stream.
+// @param w         Words.
+// @param n         Number of words.
+inline void writeLe(ostream &os, const uint16_t *w, const size_t n) {
+    string buf(2 * n, '\0');
+    for (size_t i = 0; i < n; ++i) { buf[2*i] = w[i] & 0xff; buf[2*i+1] = w[i] >> 8; }
+    os << buf;
+}
+
+// Write a program as a memory image: boot microops, data section, code segment and a final HLT.
+// @param os        Output stream (binary).
+// @param prg       Program.
+// @param fmt       Image format. Default: img_raw.
+inline void writeImg(ostream &os, const program &prg, const uint8_t fmt = img_raw) {
+    vector<uint16_t> dat = bootSeq(), code = prg.code;
+    dat.insert(dat.end(), prg.dat.begin(), prg.dat.end());
+    code.pb(HLT());
+    if (fmt == img_raw) {
+        // Header
+        os << "v2.0 raw" << nl;
+        // Init instructions
+        for (size_t i = mem_init; i < mem_idat; ++i) os << bin2hex(dat[i]) << ((i == 2 || i == 6 || i == 7) ? nl : ' ');
+        // Program
+        dat.erase(dat.begin(), dat.begin() + mem_idat);
+        dat.resize(mem_iprg - mem_idat, 0x0); // Fill remaining data section with 0s
+        writeRle(os, dat);
+        os << nl;
+        writeRle(os, code);
+    } else if (fmt == img_flat) {
+        vector<uint16_t> mem(mem_end + 1, 0x0);
+        copy(dat.begin(), dat.end(), mem.begin() + mem_init);
+        copy(code.begin(), code.end(), mem.begin() + mem_iprg);
+        writeLe(os, mem.data(), mem.size());
+    } else {
+        uint16_t hdr[] = { 0x1, 0x3 }; // Version, segments
+        os << "RC16";
+        writeLe(os, hdr, 2);
+        auto segment = [&](const uint16_t region, const uint16_t base, const uint32_t size, const vector<uint16_t> &w) {
+            uint16_t h[] = { region, base, (uint16_t)size, (uint16_t)(size >> 16), (uint16_t)w.size(), (uint16_t)(w.size() >> 16) };
+            writeLe(os, h, 6);
+            writeLe(os, w.data(), w.size());
+        };
+        segment(seg_dat, mem_init, mem_edat - mem_init + 1, dat);
+        segment(seg_prg, mem_iprg, mem_eprg - mem_iprg + 1, code);
+        segment(seg_stk, mem_istk, mem_estk - mem_istk + 1, {});
+    }
+}
+
+// Symbol file format (text, one record per line), read by the profiler of rce:
+//   rcs                                Header
+//   src <i> <file>                     Source filename of module 'i'
+//   lbl <addr> <label>                 Code label
+//   lin <addr> <n> <i> <line>          Microops [addr, addr+n) come from a source line of module 'i'
+// Numbers are decimal, addresses hexadecimal.
+
+// Write the symbols of a program: its code labels and the source line of every microop.
+// @param os        Output stream.
+// @param prg       Program.
+inline void writeSym(ostream &os, const program &prg) {
+    os << "rcs" << nl;
+    for (size_t i = 0; i < prg.srcs.size(); ++i) os << "src " << i << " " << prg.srcs[i] << nl;
+    for (auto &l : prg.lbl) os << "lbl " << bin2hex(l.second) << " " << l.first << nl;
+    for (size_t i = 0, j; i < prg.line.size(); i = j) { // Runs of microops from the same line
+        for (j = i; j < prg.line.size() && prg.line[j] == prg.line[i]; ++j);
+        os << "lin " << bin2hex(mem_iprg + i) << " " << j - i << " " << prg.line[i].first << " " << prg.line[i].second << nl;
+    }
+}
+
+#endif
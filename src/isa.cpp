@@ -11,372 +11,502 @@
 #ifndef ISA
 #define ISA
 
-// PUT <reg> <addr>: load a register with a 16bit address. Very expensive.
+#include <bit>
+
+#define putlen      13 // Microops of the longest PUT sequence
+
+// PUT <reg> <addr> at compile time, where the synthesis table is not available: the address is shifted into A 6 bits
+// at a time ('putlen' microops at most).
+// @param o         Code buffer (appended to).
 // @param r         Destination register
 // @param addr      Address.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string put(const reg &r, const uint16_t &addr, const cond &c = AL) {
-    oss os;
-    uint16_t a1 = addr >> 12; // Part 1 [4 bits]
-    uint16_t a2 = (addr >> 6) & 0x3f; // Part 2 [6 bits]
-    uint16_t a3 = addr & 0x3f; // Part 3 [6 bits]
-    os << SET(A, a1, c) << " ";
-    if (a1 != 0x0) os << SET(B, 6, c) << " " << EXC(LSL, false, false, c) << " " << MOVREG(OUT, A, c) << " ";
-    if (a2 != 0x0) os << SET(B, a2, c) << " " << EXC(ORR, false, false, c) << " " << MOVREG(OUT, A, c) << " ";
-    if (a1 != 0x0 || a2 != 0x0) os << SET(B, 6, c) << " " << EXC(LSL, false, false, c) << " " << MOVREG(OUT, A, c) << " ";
-    if (a3 != 0x0) os << SET(B, a3, c) << " " << EXC(ORR, false, false, c) << " ";
-    os << MOVREG(OUT, r, c) << " ";
-    return os.str();
+constexpr void putshift(vector<uint16_t> &o, const reg &r, const uint16_t &addr, const cond &c = AL) {
+    if (addr <= maxval && ireg(r)) { o.pb(SET(r, addr, c)); return; }
+    o.pb(SET(A, addr >> 12, c));
+    for (int sh = 6; sh >= 0; sh -= 6) {
+        o.pb(SET(B, 6, c));
+        o.pb(EXC(LSL, false, false, c));
+        o.pb(MOVREG(OUT, A, c));
+        o.pb(SET(B, (addr >> sh) & 0x3f, c));
+        o.pb(EXC(ORR, false, false, c));
+        if (sh > 0) o.pb(MOVREG(OUT, A, c));
+    }
+    o.pb(MOVREG(OUT, r, c));
 }
 
-// SET <reg> <val>: save immediate value to register.
+// PUT <reg> <addr>: load a register with a 16bit address, through the shortest known sequence (see 'synth').
+// @param o         Code buffer (appended to).
+// @param r         Destination register
+// @param addr      Address.
+// @param c         Conditional. Defualt: AL.
+// @param known     Known register contents. Default: none.
+constexpr void put(vector<uint16_t> &o, const reg &r, const uint16_t &addr, const cond &c = AL, const regvals &known = regvals()) {
+    if (is_constant_evaluated()) putshift(o, r, addr, c);
+    else synth(o, r, addr, c, known);
+}
+
+// PUT <reg> <addr>, padded with NOPs to 'putlen' microops, for addresses which are not known yet or may move.
+// @param o         Code buffer (appended to).
+// @param r         Destination register
+// @param addr      Address.
+// @param c         Conditional. Defualt: AL.
+// @param len       Microops of the sequence (no shorter than the PUT itself). Default: putlen.
+constexpr void putfixed(vector<uint16_t> &o, const reg &r, const uint16_t &addr, const cond &c = AL, const size_t &len = putlen) {
+    size_t n = o.size() + len;
+    put(o, r, addr, c);
+    while (o.size() < n) o.pb(NOP(c));
+}
+
+// SET <reg> <val>: save immediate value to register. Values exceeding 6 bits are expanded like PUT.
+// @param o         Code buffer (appended to).
 // @param r         Destination register.
 // @param val       Immediate value.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string set(const reg &r, const int &val, const cond &c = AL) {
-    oss os;
+// @param known     Known register contents. Default: none.
+constexpr void set(vector<uint16_t> &o, const reg &r, const int &val, const cond &c = AL, const regvals &known = regvals()) {
+    if (val > maxval && val <= 0xffff) { put(o, r, val, c, known); return; }
     try {
-        os << SET(r, val, c) << " ";
+        o.pb(SET(r, val, c));
     } catch (out_of_range &e) {
         throw e;
     } catch (invalid_argument &e) {
         throw e;
     }
-    return os.str();
 }
 
 // MOV <reg> <reg>: move a value from a register to another.
+// @param o         Code buffer (appended to).
 // @param r1        Source register.
 // @param r2        Destination register.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string mov(const reg &r1, const reg &r2, const cond &c = AL) {
-    return MOVREG(r1, r2, c) + " ";
+constexpr void mov(vector<uint16_t> &o, const reg &r1, const reg &r2, const cond &c = AL) {
+    o.pb(MOVREG(r1, r2, c));
 }
 
 // LDR <reg> <reg_addr>: load value from memory to register.
+// @param o         Code buffer (appended to).
 // @param r         Destination register.
 // @param r_addr    Register containing memory address.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string ldr(const reg &r, const reg &r_addr, const cond &c = AL) {
-    oss os;
-    os << MOVREG(r_addr, MAR, c) << " ";
+constexpr void ldr(vector<uint16_t> &o, const reg &r, const reg &r_addr, const cond &c = AL) {
+    o.pb(MOVREG(r_addr, MAR, c));
     try {
-        os << MOVMEM(false, r, c) << " ";
+        o.pb(MOVMEM(false, r, c));
     } catch (invalid_argument &e) {
         throw e;
     }
-    return os.str();
 }
 
 // STR <reg> <reg_addr>: store value in memory from register.
+// @param o         Code buffer (appended to).
 // @param r         Source register.
 // @param r_addr    Register containing memory address.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string str(const reg &r, const reg &r_addr, const cond &c = AL) {
-    oss os;
-    os << MOVREG(r_addr, MAR, c) << " ";
+constexpr void str(vector<uint16_t> &o, const reg &r, const reg &r_addr, const cond &c = AL) {
+    o.pb(MOVREG(r_addr, MAR, c));
     try {
-        os << MOVMEM(true, r, c) << " ";
+        o.pb(MOVMEM(true, r, c));
     } catch (invalid_argument &e) {
         throw e;
     }
-    return os.str();
 }
 
 // ADD <reg> <reg> <reg>: add two values into a register.
+// @param o         Code buffer (appended to).
 // @param r1        Register containing operand 1.
 // @param r2        Register containing operand 2.
 // @param r3        Destination register.
 // @param s         Update flags if 1, do not otherwise.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string add(const reg &r1, const reg &r2, const reg &r3, const bool &s, const cond &c = AL) {
-    oss os;
+constexpr void add(vector<uint16_t> &o, const reg &r1, const reg &r2, const reg &r3, const bool &s, const cond &c = AL) {
     if (s && c != AL) { // If flags need to get updated and condition is not AL, we need to copy r3 to OUT to avoid errors
-        os << MOVREG(r3, A) << " ";
-        os << SET(B, 0) << " ";
-        os << EXC(ADD, false, false) << " ";
+        o.pb(MOVREG(r3, A));
+        o.pb(SET(B, 0));
+        o.pb(EXC(ADD, false, false));
     }
-    os << MOVREG(r1, A, c) << " ";
-    os << MOVREG(r2, B, c) << " ";
-    os << EXC(ADD, false, s, c) << " ";
-    os << MOVREG(OUT, r3, (s?AL:c)) << " ";
-    return os.str();
+    o.pb(MOVREG(r1, A, c));
+    o.pb(MOVREG(r2, B, c));
+    o.pb(EXC(ADD, false, s, c));
+    o.pb(MOVREG(OUT, r3, (s?AL:c)));
 }
 
 // SUB <reg> <reg> <reg>: subtract two values into a register.
+// @param o         Code buffer (appended to).
 // @param r1        Register containing operand 1.
 // @param r2        Register containing operand 2.
 // @param r3        Destination register.
 // @param s         Update flags if 1, do not otherwise.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string sub(const reg &r1, const reg &r2, const reg &r3, const bool &s, const cond &c = AL) {
-    oss os;
+constexpr void sub(vector<uint16_t> &o, const reg &r1, const reg &r2, const reg &r3, const bool &s, const cond &c = AL) {
     if (s && c != AL) { // If flags need to get updated and condition is not AL, we need to copy r3 to OUT to avoid errors
-        os << MOVREG(r3, A) << " ";
-        os << SET(B, 0) << " ";
-        os << EXC(ADD, false, false) << " ";
+        o.pb(MOVREG(r3, A));
+        o.pb(SET(B, 0));
+        o.pb(EXC(ADD, false, false));
     }
-    os << MOVREG(r1, A, c) << " ";
-    os << MOVREG(r2, B, c) << " ";
-    os << EXC(ADD, true, s, c) << " ";
-    os << MOVREG(OUT, r3, (s?AL:c)) << " ";
-    return os.str();
+    o.pb(MOVREG(r1, A, c));
+    o.pb(MOVREG(r2, B, c));
+    o.pb(EXC(ADD, true, s, c));
+    o.pb(MOVREG(OUT, r3, (s?AL:c)));
 }
 
 // AND <reg> <reg> <reg>: perform bitwise and of two values into a register.
+// @param o         Code buffer (appended to).
 // @param r1        Register containing operand 1.
 // @param r2        Register containing operand 2.
 // @param r3        Destination register.
 // @param s         Update flags if 1, do not otherwise.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string _and(const reg &r1, const reg &r2, const reg &r3, const bool &s, const cond &c = AL) {
-    oss os;
+constexpr void _and(vector<uint16_t> &o, const reg &r1, const reg &r2, const reg &r3, const bool &s, const cond &c = AL) {
     if (s && c != AL) { // If flags need to get updated and condition is not AL, we need to copy r3 to OUT to avoid errors
-        os << MOVREG(r3, A) << " ";
-        os << SET(B, 0) << " ";
-        os << EXC(ADD, false, false) << " ";
+        o.pb(MOVREG(r3, A));
+        o.pb(SET(B, 0));
+        o.pb(EXC(ADD, false, false));
     }
-    os << MOVREG(r1, A, c) << " ";
-    os << MOVREG(r2, B, c) << " ";
-    os << EXC(AND, false, s, c) << " ";
-    os << MOVREG(OUT, r3, (s?AL:c)) << " ";
-    return os.str();
+    o.pb(MOVREG(r1, A, c));
+    o.pb(MOVREG(r2, B, c));
+    o.pb(EXC(AND, false, s, c));
+    o.pb(MOVREG(OUT, r3, (s?AL:c)));
 }
 
 // ORR <reg> <reg> <reg>: perform bitwise or of two values into a register.
+// @param o         Code buffer (appended to).
 // @param r1        Register containing operand 1.
 // @param r2        Register containing operand 2.
 // @param r3        Destination register.
 // @param s         Update flags if 1, do not otherwise.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string orr(const reg &r1, const reg &r2, const reg &r3, const bool &s, const cond &c = AL) {
-    oss os;
+constexpr void orr(vector<uint16_t> &o, const reg &r1, const reg &r2, const reg &r3, const bool &s, const cond &c = AL) {
     if (s && c != AL) { // If flags need to get updated and condition is not AL, we need to copy r3 to OUT to avoid errors
-        os << MOVREG(r3, A) << " ";
-        os << SET(B, 0) << " ";
-        os << EXC(ADD, false, false) << " ";
+        o.pb(MOVREG(r3, A));
+        o.pb(SET(B, 0));
+        o.pb(EXC(ADD, false, false));
     }
-    os << MOVREG(r1, A, c) << " ";
-    os << MOVREG(r2, B, c) << " ";
-    os << EXC(ORR, false, s, c) << " ";
-    os << MOVREG(OUT, r3, (s?AL:c)) << " ";
-    return os.str();
+    o.pb(MOVREG(r1, A, c));
+    o.pb(MOVREG(r2, B, c));
+    o.pb(EXC(ORR, false, s, c));
+    o.pb(MOVREG(OUT, r3, (s?AL:c)));
 }
 
 // EOR <reg> <reg> <reg>: perform bitwise xor of two values into a register.
+// @param o         Code buffer (appended to).
 // @param r1        Register containing operand 1.
 // @param r2        Register containing operand 2.
 // @param r3        Destination register.
 // @param s         Update flags if 1, do not otherwise.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string eor(const reg &r1, const reg &r2, const reg &r3, const bool &s, const cond &c = AL) {
-    oss os;
+constexpr void eor(vector<uint16_t> &o, const reg &r1, const reg &r2, const reg &r3, const bool &s, const cond &c = AL) {
     if (s && c != AL) { // If flags need to get updated and condition is not AL, we need to copy r3 to OUT to avoid errors
-        os << MOVREG(r3, A) << " ";
-        os << SET(B, 0) << " ";
-        os << EXC(ADD, false, false) << " ";
+        o.pb(MOVREG(r3, A));
+        o.pb(SET(B, 0));
+        o.pb(EXC(ADD, false, false));
     }
-    os << MOVREG(r1, A, c) << " ";
-    os << MOVREG(r2, B, c) << " ";
-    os << EXC(EOR, false, s, c) << " ";
-    os << MOVREG(OUT, r3, (s?AL:c)) << " ";
-    return os.str();
+    o.pb(MOVREG(r1, A, c));
+    o.pb(MOVREG(r2, B, c));
+    o.pb(EXC(EOR, false, s, c));
+    o.pb(MOVREG(OUT, r3, (s?AL:c)));
 }
 
 // LSL <reg> <reg> <reg_shift>: perform logical left shift of a register into another register.
+// @param o         Code buffer (appended to).
 // @param r1        Register containing operand 1.
 // @param r_shift   Register containing shift value.
 // @param r2        Destination register.
 // @param s         Update flags if 1, do not otherwise.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string lsl(const reg &r1, const reg &r_shift, const reg &r2, const bool &s, const cond &c = AL) {
-    oss os;
+constexpr void lsl(vector<uint16_t> &o, const reg &r1, const reg &r_shift, const reg &r2, const bool &s, const cond &c = AL) {
     if (s && c != AL) { // If flags need to get updated and condition is not AL, we need to copy reg2 to OUT to avoid errors
-        os << MOVREG(r2, A) << " ";
-        os << SET(B, 0) << " ";
-        os << EXC(ADD, false, false) << " ";
+        o.pb(MOVREG(r2, A));
+        o.pb(SET(B, 0));
+        o.pb(EXC(ADD, false, false));
     }
-    os << MOVREG(r1, A, c) << " ";
-    os << MOVREG(r_shift, B, c) << " ";
-    os << EXC(LSL, false, s, c) << " ";
-    os << MOVREG(OUT, r2, (s?AL:c)) << " ";
-    return os.str();
+    o.pb(MOVREG(r1, A, c));
+    o.pb(MOVREG(r_shift, B, c));
+    o.pb(EXC(LSL, false, s, c));
+    o.pb(MOVREG(OUT, r2, (s?AL:c)));
 }
 
 // LSR <reg> <reg> <reg_shift>: perform logical right shift of a register into another register.
+// @param o         Code buffer (appended to).
 // @param r1        Register containing operand 1.
 // @param r_shift   Register containing shift value.
 // @param r2        Destination register.
 // @param s         Update flags if 1, do not otherwise.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string lsr(const reg &r1, const reg &r_shift, const reg &r2, const bool &s, const cond &c = AL) {
-    oss os;
+constexpr void lsr(vector<uint16_t> &o, const reg &r1, const reg &r_shift, const reg &r2, const bool &s, const cond &c = AL) {
     if (s && c != AL) { // If flags need to get updated and condition is not AL, we need to copy reg2 to OUT to avoid errors
-        os << MOVREG(r2, A) << " ";
-        os << SET(B, 0) << " ";
-        os << EXC(ADD, false, false) << " ";
+        o.pb(MOVREG(r2, A));
+        o.pb(SET(B, 0));
+        o.pb(EXC(ADD, false, false));
     }
-    os << MOVREG(r1, A, c) << " ";
-    os << MOVREG(r_shift, B, c) << " ";
-    os << EXC(LSR, false, s, c) << " ";
-    os << MOVREG(OUT, r2, (s?AL:c)) << " ";
-    return os.str();
+    o.pb(MOVREG(r1, A, c));
+    o.pb(MOVREG(r_shift, B, c));
+    o.pb(EXC(LSR, false, s, c));
+    o.pb(MOVREG(OUT, r2, (s?AL:c)));
 }
 
 // ASR <reg> <reg> <reg_shift>: perform arithmetical right shift of a register into another register.
+// @param o         Code buffer (appended to).
 // @param r1        Register containing operand 1.
 // @param r_shift   Register containing shift value.
 // @param r2        Destination register.
 // @param s         Update flags if 1, do not otherwise.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string asr(const reg &r1, const reg &r_shift, const reg &r2, const bool &s, const cond &c = AL) {
-    oss os;
+constexpr void asr(vector<uint16_t> &o, const reg &r1, const reg &r_shift, const reg &r2, const bool &s, const cond &c = AL) {
     if (s && c != AL) { // If flags need to get updated and condition is not AL, we need to copy reg2 to OUT to avoid errors
-        os << MOVREG(r2, A) << " ";
-        os << SET(B, 0) << " ";
-        os << EXC(ADD, false, false) << " ";
+        o.pb(MOVREG(r2, A));
+        o.pb(SET(B, 0));
+        o.pb(EXC(ADD, false, false));
+    }
+    o.pb(MOVREG(r1, A, c));
+    o.pb(MOVREG(r_shift, B, c));
+    o.pb(EXC(ASR, false, s, c));
+    o.pb(MOVREG(OUT, r2, (s?AL:c)));
+}
+
+// Ways of multiplying by a constant k (see 'mulplan')
+#define mul_shl     0x0 // k = m << t
+#define mul_add     0x1 // k = (m << t) + 1
+#define mul_sub     0x2 // k = (m << t) - 1
+#define mul_fad     0x3 // k = m * ((1 << t) + 1), m kept in the scratch register
+#define mul_fsb     0x4 // k = m * ((1 << t) - 1), m kept in the scratch register
+#define mul_neg     0x5 // k = -m
+
+// Last step of the cheapest sequence leaving rs*k in OUT.
+struct mulstep {
+    uint16_t k; // Factor
+    int cost; // Microops
+    uint8_t kind; // mul_shl, mul_add, mul_sub, mul_fad, mul_fsb or mul_neg
+    uint8_t t; // Shift
+    uint16_t m; // Factor the step starts from
+};
+
+// Find the cheapest sequence of shifts, additions and subtractions leaving rs*k in OUT (k >= 2), chaining them through
+// A, B and OUT, so that rs is read as many times as needed and no register is written but the scratch one, if any.
+// @param k         Factor.
+// @param scratch   Whether a scratch register is available.
+// @param plan      Steps found so far (appended to).
+// @return          Microops.
+constexpr int mulplan(const uint16_t k, const bool scratch, vector<mulstep> &plan) {
+    for (const mulstep &s : plan) if (s.k == k) return s.cost;
+    mulstep best = { k, 0xffff, mul_shl, 0, 0 };
+    auto consider = [&](const int cost, const uint8_t kind, const uint8_t t, const uint16_t m) { if (cost < best.cost) best = { k, cost, kind, t, m }; };
+    auto ina = [&](const uint16_t m) { return (m == 1) ? 1 : mulplan(m, scratch, plan) + 1; }; // rs*m into A (or B)
+    if (!(k & 0x1)) consider(ina(k >> countr_zero(k)) + 2, mul_shl, countr_zero(k), k >> countr_zero(k)); // LSL
+    else for (uint32_t v : { k - 1u, k + 1u }) { // LSL, MOV OUT A, MOV rs B, ADD (or SUB)
+        if (v == 0 || v > 0xffff) continue;
+        consider(ina(v >> countr_zero(v)) + 5, (v < k) ? mul_add : mul_sub, countr_zero(v), v >> countr_zero(v));
+    }
+    if (scratch) for (uint8_t t = 1; t < 16; ++t) { // MOV OUT scratch, LSL, MOV OUT A, MOV scratch B, ADD (or SUB)
+        for (uint32_t g : { (1u << t) + 1, (1u << t) - 1 }) if (g > 1 && k % g == 0 && k / g > 1) consider(mulplan(k / g, scratch, plan) + 7, (g > (1u << t)) ? mul_fad : mul_fsb, t, k / g);
+    }
+    if (k > 0x8000) consider(ina(0x10000 - k) + 2, mul_neg, 0, 0x10000 - k); // SET A 0, SUB
+    plan.pb(best);
+    return best.cost;
+}
+
+// Emit the sequence found by 'mulplan', leaving rs*k in OUT.
+// @param o         Code buffer (appended to).
+// @param k         Factor.
+// @param rs        Register holding the value to be multiplied.
+// @param tmp       Scratch register (if the plan uses it).
+// @param plan      Steps found by 'mulplan'.
+// @param c         Conditional.
+constexpr void mulemit(vector<uint16_t> &o, const uint16_t k, const reg &rs, const reg &tmp, const vector<mulstep> &plan, const cond &c) {
+    const mulstep &s = *find_if(plan.begin(), plan.end(), [&](const mulstep &x) { return x.k == k; });
+    auto load = [&](const uint16_t m, const reg &r) { // rs*m into A or B
+        if (m == 1) { o.pb(MOVREG(rs, r, c)); return; }
+        mulemit(o, m, rs, tmp, plan, c);
+        o.pb(MOVREG(OUT, r, c));
+    };
+    if (s.kind == mul_neg) {
+        load(s.m, B);
+        o.pb(SET(A, 0, c));
+        o.pb(EXC(ADD, true, false, c));
+        return;
     }
-    os << MOVREG(r1, A, c) << " ";
-    os << MOVREG(r_shift, B, c) << " ";
-    os << EXC(ASR, false, s, c) << " ";
-    os << MOVREG(OUT, r2, (s?AL:c)) << " ";
-    return os.str();
+    reg src = rs; // Register to be added to (or subtracted from) the shifted value
+    if (s.kind == mul_fad || s.kind == mul_fsb) {
+        mulemit(o, s.m, rs, tmp, plan, c);
+        o.pb(MOVREG(OUT, tmp, c));
+        o.pb(MOVREG(tmp, A, c));
+        src = tmp;
+    } else load(s.m, A);
+    o.pb(SET(B, s.t, c));
+    o.pb(EXC(LSL, false, false, c));
+    if (s.kind == mul_shl) return;
+    o.pb(MOVREG(OUT, A, c));
+    o.pb(MOVREG(src, B, c));
+    o.pb(EXC(ADD, s.kind == mul_sub || s.kind == mul_fsb, false, c));
+}
+
+// MLI <reg> <reg> <k>: multiply a register by a constant into another register, through the cheapest sequence of
+// shifts, additions and subtractions: at most 46 microops (40 if the registers differ), so it never pays to call 'mul'
+// of the runtime library instead (145 or more). Only the destination register is written (as scratch, if it differs
+// from the source one), and flags are not updated.
+// @param o         Code buffer (appended to).
+// @param r1        Register containing the value.
+// @param k         Constant (taken modulo 2^16).
+// @param r2        Destination register.
+// @param c         Conditional. Defualt: AL.
+constexpr void mli(vector<uint16_t> &o, const reg &r1, const uint16_t &k, const reg &r2, const cond &c = AL) {
+    if (k == 0) { o.pb(SET(r2, 0, c)); return; }
+    if (k == 1) { if (r1 != r2) o.pb(MOVREG(r1, r2, c)); return; }
+    vector<mulstep> plan;
+    mulplan(k, r1 != r2, plan);
+    mulemit(o, k, r1, r2, plan, c);
+    o.pb(MOVREG(OUT, r2, c));
 }
 
 // PRT <reg>: print value contained in register.
+// @param o         Code buffer (appended to).
 // @param r         Source register.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string prt(const reg &r, const cond &c = AL) {
-    return MOVREG(r, OR, c) + " ";
+constexpr void prt(vector<uint16_t> &o, const reg &r, const cond &c = AL) {
+    o.pb(MOVREG(r, OR, c));
 }
 
 // CMP <reg> <reg>: update flags basing on subtraction.
+// @param o         Code buffer (appended to).
 // @param r1        Register 1.
 // @param r2        Register 2.
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string cmp(const reg &r1, const reg &r2, const cond &c = AL) {
-    oss os;
+constexpr void cmp(vector<uint16_t> &o, const reg &r1, const reg &r2, const cond &c = AL) {
     // Flags do get updated, but result remains in OUT register
-    os << MOVREG(r1, A, c) << " ";
-    os << MOVREG(r2, B, c) << " ";
-    os << EXC(ADD, true, true, c) << " ";
-    return os.str();
+    o.pb(MOVREG(r1, A, c));
+    o.pb(MOVREG(r2, B, c));
+    o.pb(EXC(ADD, true, true, c));
 }
 
 // JMP <addr>: jump to a certain address.
+// @param o         Code buffer (appended to).
 // @param addr      Address to jump to. OFFSET: this value is added to the start of the code segment. MAX: 0x3fff (32kB code segment covered).
 // @param c         Conditional. Default: AL.
-// @return          Hexadecimal string representation of command.
-inline string jmp(const uint16_t &addr, const cond &c = AL) {
-    oss os;
+constexpr void jmp(vector<uint16_t> &o, const uint16_t &addr, const cond &c = AL) {
     try {
-        os << LJR(addr) << " "; // Load JR
+        o.pb(LJR(addr)); // Load JR
     } catch (out_of_range &e) {
         throw e;
     }
-    os << MOVREG(JR, PC, c) << " "; // Move to PC (with condition)
-    return os.str();
+    o.pb(MOVREG(JR, PC, c)); // Move to PC (with condition)
 }
 
 // PSH <reg>: push a register to the stack.
+// @param o         Code buffer (appended to).
 // @param r         Register to be pushed on the stack.
 // @param c         Conditional. Default: AL.
-// @return          Hexadecimal string representation of command.
-inline string psh(const reg &r, const cond &c = AL) {
-    oss os;
+constexpr void psh(vector<uint16_t> &o, const reg &r, const cond &c = AL) {
     // Push register
-    os << MOVREG(SP, MAR, c) << " ";
+    o.pb(MOVREG(SP, MAR, c));
     try {
-        os << MOVMEM(true, r, c) << " ";
+        o.pb(MOVMEM(true, r, c));
     } catch (invalid_argument &e) {
         throw e;
     }
     // Decrement link register
-    os << MOVREG(SP, A, c) << " ";
-    os << SET(B, 1, c) << " ";
-    os << EXC(ADD, true, false, c) << " ";
-    os << MOVREG(OUT, SP, c) << " ";
-    return os.str();
+    o.pb(MOVREG(SP, A, c));
+    o.pb(SET(B, 1, c));
+    o.pb(EXC(ADD, true, false, c));
+    o.pb(MOVREG(OUT, SP, c));
 }
 
 // POP <reg>: pop a register from the stack.
+// @param o         Code buffer (appended to).
 // @param r         Register to be popped from the stack.
 // @param c         Conditional. Default: AL.
-// @return          Hexadecimal string representation of command.
-inline string pop(const reg &r, const cond &c = AL) {
-    oss os;
+constexpr void pop(vector<uint16_t> &o, const reg &r, const cond &c = AL) {
     // Increment link register
-    os << MOVREG(SP, A, c) << " ";
-    os << SET(B, 1, c) << " ";
-    os << EXC(ADD, false, false, c) << " ";
-    os << MOVREG(OUT, SP, c) << " ";
+    o.pb(MOVREG(SP, A, c));
+    o.pb(SET(B, 1, c));
+    o.pb(EXC(ADD, false, false, c));
+    o.pb(MOVREG(OUT, SP, c));
     // Pop register
-    os << MOVREG(SP, MAR, c) << " ";
+    o.pb(MOVREG(SP, MAR, c));
     try {
-        os << MOVMEM(false, r, c) << " ";
+        o.pb(MOVMEM(false, r, c));
     } catch (invalid_argument &e) {
         throw e;
     }
-    return os.str();
+}
+
+// PSH {<reg>, ...}: push many registers to the stack, in the given order, moving SP once.
+// There is no auto-decrement: every slot is addressed through the ALU, from SP held in A.
+// @param o         Code buffer (appended to).
+// @param rs        Registers to be pushed on the stack (R0..R7, except SP and PC).
+// @param c         Conditional. Default: AL.
+constexpr void pshm(vector<uint16_t> &o, const vector<reg> &rs, const cond &c = AL) {
+    if (rs.empty() || rs.size() > maxval) throw invalid_argument("Invalid number of registers.");
+    for (const reg &r : rs) if (r > R7 || r == SP || r == PC) throw invalid_argument("The given register cannot be in a list.");
+    o.pb(MOVREG(SP, MAR, c));
+    o.pb(MOVMEM(true, rs[0], c));
+    o.pb(MOVREG(SP, A, c));
+    for (size_t i = 1; i < rs.size(); ++i) {
+        o.pb(SET(B, i, c));
+        o.pb(EXC(ADD, true, false, c)); // SP - i
+        o.pb(MOVREG(OUT, MAR, c));
+        o.pb(MOVMEM(true, rs[i], c));
+    }
+    o.pb(SET(B, rs.size(), c));
+    o.pb(EXC(ADD, true, false, c));
+    o.pb(MOVREG(OUT, SP, c));
+}
+
+// POP {<reg>, ...}: pop many registers from the stack, in the reverse order (so that the list of a PSH restores it),
+// moving SP once.
+// @param o         Code buffer (appended to).
+// @param rs        Registers to be popped from the stack (R0..R7, except SP and PC).
+// @param c         Conditional. Default: AL.
+constexpr void popm(vector<uint16_t> &o, const vector<reg> &rs, const cond &c = AL) {
+    if (rs.empty() || rs.size() > maxval) throw invalid_argument("Invalid number of registers.");
+    for (const reg &r : rs) if (r > R7 || r == SP || r == PC) throw invalid_argument("The given register cannot be in a list.");
+    o.pb(MOVREG(SP, A, c));
+    for (size_t i = 1; i <= rs.size(); ++i) {
+        o.pb(SET(B, i, c));
+        o.pb(EXC(ADD, false, false, c)); // SP + i
+        o.pb(MOVREG(OUT, MAR, c));
+        o.pb(MOVMEM(false, rs[rs.size() - i], c));
+    }
+    o.pb(MOVREG(OUT, SP, c));
 }
 
 // CAL <addr>: call a function (label or address).
+// @param o         Code buffer (appended to).
 // @param addr      Address to jump to.
 // @param c         Conditional. Default: AL.
-// @return          Hexadecimal string representation of command.
-inline string cal(const uint16_t &addr, const cond &c = AL) {
-    oss os;
+constexpr void cal(vector<uint16_t> &o, const uint16_t &addr, const cond &c = AL) {
     // Compute address of next instruction (not PC points to next microinstruction)
-    os << MOVREG(PC, A, c) << " ";
-    os << SET(B, 5, c) << " ";
-    os << EXC(ADD, false, false, c) << " ";
-    os << MOVREG(OUT, LR, c) << " ";
+    o.pb(MOVREG(PC, A, c));
+    o.pb(SET(B, 5, c));
+    o.pb(EXC(ADD, false, false, c));
+    o.pb(MOVREG(OUT, LR, c));
     // Jump
     try {
-        os << LJR(addr) << " ";
+        o.pb(LJR(addr));
     } catch (invalid_argument &e) {
         throw e;
     }
-    os << MOVREG(JR, PC, c) << " ";
-    return os.str();
+    o.pb(MOVREG(JR, PC, c));
 }
 
 // RET: return from a function.
+// @param o         Code buffer (appended to).
 // @param c         Conditional. Default: AL.
-// @return          Hexadecimal string representation of command.
-inline string ret(const cond &c = AL) {
-    oss os;
-    os << MOVREG(LR, PC, c) << " ";
-    return os.str();
+constexpr void ret(vector<uint16_t> &o, const cond &c = AL) {
+    o.pb(MOVREG(LR, PC, c));
 }
 
 // NOP: do nothing.
+// @param o         Code buffer (appended to).
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string nop(const cond &c = AL) {
-    return NOP(c) + " ";
+constexpr void nop(vector<uint16_t> &o, const cond &c = AL) {
+    o.pb(NOP(c));
 }
 
 // HLT: halt program execution.
+// @param o         Code buffer (appended to).
 // @param c         Conditional. Defualt: AL.
-// @return          Hexadecimal string representation of command.
-inline string hlt(const cond &c = AL) {
-    return HLT(c) + " ";
+constexpr void hlt(vector<uint16_t> &o, const cond &c = AL) {
+    o.pb(HLT(c));
 }
 
 #endif
\ No newline at end of file
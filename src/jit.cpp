@@ -0,0 +1,431 @@
+/**
+ * ===================
+ * RCE - RC16 EMULATOR
+ * ===================
+ *
+ * X86-64 DYNAMIC BINARY TRANSLATOR
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef JIT
+#define JIT
+
+#include <sys/mman.h>
+#include <cstring>
+
+// Translator settings
+#define jit_size        (16 << 20) // Size of the code buffer
+#define jit_hot         8 // Executions of a block start before it gets translated
+#define jit_maxblk      256 // Maximum number of microops in a block
+#define jit_cold        64 // Maximum number of microops interpreted in a row on cold paths
+
+// Exit codes returned by translated code ('exit_link + i' asks to link exit 'i')
+#define exit_dyn        0 // PC stored in the machine state
+#define exit_smc        1 // A store hit the code segment: translations are stale
+#define exit_link       2
+
+#if defined(__x86_64__)
+
+// Host registers, numbered as in x86-64 encodings
+enum hreg : uint8_t { EAX = 0, ECX = 1, EDX = 2, EBX = 3, ESP = 4, EBP = 5, ESI = 6, EDI = 7, E8, E9, E10, E11, E12, E13, E14, E15, NOH = 0xff };
+
+// Host register holding each RC16 register file slot. PC is known statically inside a block, JR and OR live in the machine state.
+constexpr hreg hmap[16] = { ESI, EDI, E8, E9, E10, E11, E12, NOH, E13, E14, E15, EBP, NOH, NOH, NOH, NOH };
+
+// Host registers which the System V ABI wants preserved.
+constexpr hreg hsaved[6] = { EBX, EBP, E12, E13, E14, E15 };
+
+// Check whether a called function may overwrite a host register (mapped ones are ESI, EDI and E8..E11).
+constexpr bool hclobbered(const hreg h) { return h == ESI || h == EDI || (h >= E8 && h <= E11); }
+
+// Minimal x86-64 machine code emitter writing into a fixed buffer.
+struct x64 {
+    uint8_t *p = nullptr; // Next byte
+
+    void b(const uint8_t x) { *p++ = x; }
+    void d(const uint32_t x) { memcpy(p, &x, 4); p += 4; }
+    void q(const uint64_t x) { memcpy(p, &x, 8); p += 8; }
+
+    // Emit optional prefixes and an opcode for a 'reg, r/m' instruction.
+    void op(const vector<uint8_t> &opc, const uint8_t reg, const uint8_t rm, const bool w, const bool p16, const bool x = false) {
+        if (p16) b(0x66);
+        uint8_t rex = 0x40 | (w << 3) | ((reg >> 3) << 2) | (x << 1) | (rm >> 3);
+        if (rex != 0x40) b(rex);
+        for (uint8_t o : opc) b(o);
+    }
+    // reg, reg form.
+    void rr(const vector<uint8_t> &opc, const uint8_t reg, const uint8_t rm, const bool w = false, const bool p16 = false) {
+        op(opc, reg, rm, w, p16);
+        b(0xc0 | ((reg & 0x7) << 3) | (rm & 0x7));
+    }
+    // reg, [rbx+disp32] form (machine state fields).
+    void rs(const vector<uint8_t> &opc, const uint8_t reg, const int32_t disp, const bool w = false, const bool p16 = false) {
+        op(opc, reg, EBX, w, p16);
+        b(0x80 | ((reg & 0x7) << 3) | EBX);
+        d(disp);
+    }
+    // reg, [rbx+rbp*2+disp32] form (memory word addressed by MAR).
+    void rm(const vector<uint8_t> &opc, const uint8_t reg, const int32_t disp, const bool p16 = false) {
+        op(opc, reg, EBX, false, p16);
+        b(0x84 | ((reg & 0x7) << 3));
+        b(0x40 | (EBP << 3) | EBX);
+        d(disp);
+    }
+    // reg, [rip+disp32] form, addressing an absolute location.
+    void rip(const vector<uint8_t> &opc, const uint8_t reg, const void *at, const bool w = false) {
+        op(opc, reg, 0x0, w, false);
+        b(0x05 | ((reg & 0x7) << 3));
+        d((uint32_t)((uint8_t*)at - (p + 4)));
+    }
+
+    void mov(const uint8_t dst, const uint8_t src) { rr({ 0x89 }, src, dst); }
+    void movi(const uint8_t dst, const uint32_t imm) { if (dst >> 3) b(0x41); b(0xb8 | (dst & 0x7)); d(imm); }
+    void movzx16(const uint8_t dst, const uint8_t src) { rr({ 0x0f, 0xb7 }, dst, src); }
+    void movsx16(const uint8_t dst, const uint8_t src) { rr({ 0x0f, 0xbf }, dst, src); }
+    void alu(const uint8_t opc, const uint8_t dst, const uint8_t src) { rr({ opc }, src, dst); } // add 01, or 09, and 21, sub 29, xor 31
+    void alui(const uint8_t ext, const uint8_t dst, const uint32_t imm) { rr({ 0x81 }, ext, dst); d(imm); } // add /0, and /4, cmp /7
+    void shi(const uint8_t ext, const uint8_t dst, const uint8_t n) { rr({ 0xc1 }, ext, dst); b(n); } // shl /4, shr /5
+    void shcl(const uint8_t ext, const uint8_t dst) { rr({ 0xd3 }, ext, dst); } // shl /4, shr /5, sar /7
+    void inv(const uint8_t dst) { rr({ 0xf7 }, 0x2, dst); }
+    void cmovc(const uint8_t dst, const uint8_t src) { rr({ 0x0f, 0x42 }, dst, src); }
+    void bt(const uint8_t base, const uint8_t idx) { rr({ 0x0f, 0xa3 }, idx, base); }
+    // lea dst, [base+idx+disp8]
+    void lea(const uint8_t dst, const uint8_t base, const uint8_t idx, const int8_t disp) {
+        op({ 0x8d }, dst, base, false, false, idx >> 3);
+        b(0x44 | ((dst & 0x7) << 3));
+        b(((idx & 0x7) << 3) | (base & 0x7));
+        b(disp);
+    }
+    // jcc/jmp rel32 with a placeholder target: returns the position of the displacement.
+    uint8_t *jcc(const uint8_t cc) { b(0x0f); b(0x80 | cc); d(0); return p - 4; }
+    uint8_t *jmp() { b(0xe9); d(0); return p - 4; }
+    static void patch(uint8_t *rel, const uint8_t *to) { int32_t x = to - (rel + 4); memcpy(rel, &x, 4); }
+};
+
+// Write to the output register, called from translated code.
+// @param m         Machine.
+// @param v         Value.
+static void jitOut(rc16 *m, const uint16_t v) {
+    m->r[OR] = v;
+    m->out.pb(v);
+}
+
+// Exit of a translated block towards a statically known address.
+struct jexit {
+    uint8_t *rel; // Displacement of the jump to be linked
+    uint16_t to; // Target address
+};
+
+// Translated block.
+struct jblock {
+    uint8_t *entry = nullptr; // Host code
+    uint16_t len = 0; // Maximum number of microops executed
+};
+
+// Dynamic binary translator from RC16 microops to x86-64, with an interpreter fallback.
+struct jit {
+    uint8_t *buf = nullptr; // Code buffer (data area, trampolines, then blocks)
+    x64 e; // Emitter
+    uint64_t *lim = nullptr; // Microop budget, read by block prologues
+    uint8_t *epilogue = nullptr; // Stores mapped registers back and returns to the dispatcher
+    uint8_t *base = nullptr; // First byte of block code
+    uint16_t (*enter)(rc16*, const uint8_t*) = nullptr; // Loads mapped registers and jumps into a block
+    vector<jblock> blk = vector<jblock>(mem_eprg - mem_iprg + 1); // Blocks, by start address in the code segment
+    vector<uint16_t> hits = vector<uint16_t>(mem_eprg - mem_iprg + 1); // Execution counters of block starts
+    vector<jexit> exits; // Exits which may be linked
+    uint64_t flushes = 0; // Number of times translations were dropped
+    bool check = false; // Differential mode: verify every block against the interpreter
+    rc16 *ref = nullptr; // Reference machine of the differential mode
+    int32_t o_r, o_flg, o_hlt, o_cyc, o_mem; // Offsets of machine state fields
+
+    jit() {
+        buf = (uint8_t*)mmap(nullptr, jit_size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buf == MAP_FAILED) throw runtime_error("Cannot allocate executable memory.");
+        rc16 *m = new rc16();
+        o_r = (uint8_t*)&m->r - (uint8_t*)m; o_flg = (uint8_t*)&m->flg - (uint8_t*)m; o_hlt = (uint8_t*)&m->hlt - (uint8_t*)m; o_cyc = (uint8_t*)&m->cyc - (uint8_t*)m; o_mem = (uint8_t*)&m->mem - (uint8_t*)m;
+        delete m;
+        lim = (uint64_t*)buf;
+        e.p = buf + 64;
+        // Trampoline: enter(m, block)
+        enter = (uint16_t (*)(rc16*, const uint8_t*))e.p;
+        for (hreg h : hsaved) { if (h >> 3) e.b(0x41); e.b(0x50 | (h & 0x7)); } // push
+        e.rr({ 0x89 }, EDI, EBX, true); // mov rbx, rdi
+        e.rr({ 0x89 }, ESI, EAX, true); // mov rax, rsi
+        for (uint8_t s = 0; s < 16; ++s) if (hmap[s] != NOH) e.rs({ 0x0f, 0xb7 }, hmap[s], o_r + 2*s); // movzx
+        e.b(0xff); e.b(0xe0); // jmp rax
+        // Epilogue: exit code in eax
+        epilogue = e.p;
+        for (uint8_t s = 0; s < 16; ++s) if (hmap[s] != NOH) e.rs({ 0x89 }, hmap[s], o_r + 2*s, false, true); // mov word
+        for (int i = 5; i >= 0; --i) { if (hsaved[i] >> 3) e.b(0x41); e.b(0x58 | (hsaved[i] & 0x7)); } // pop
+        e.b(0xc3); // ret
+        base = e.p;
+    }
+
+    ~jit() {
+        munmap(buf, jit_size);
+        delete ref;
+    }
+
+    // Drop every translation.
+    void flush() {
+        fill(blk.begin(), blk.end(), jblock());
+        exits.clear();
+        e.p = base;
+        ++flushes;
+    }
+
+    // Evaluate a condition into the host carry flag (clobbers eax, ecx).
+    void cond(const uint16_t msk) {
+        e.rs({ 0x0f, 0xb6 }, ECX, o_flg); // movzx ecx, byte [flg]
+        e.movi(EAX, msk);
+        e.bt(EAX, ECX);
+    }
+
+    // Load a source slot into a host register, unless it is already mapped to one.
+    // @return          Host register holding the value.
+    uint8_t src(const uint8_t slot, const uint16_t pc, const int32_t jr, const uint8_t tmp) {
+        if (hmap[slot] != NOH) return hmap[slot];
+        if (slot == PC) e.movi(tmp, pc);
+        else if (slot == JR && jr >= 0) e.movi(tmp, jr);
+        else if (slot == JR) e.rs({ 0x0f, 0xb7 }, tmp, o_r + 2*JR);
+        else e.movi(tmp, 0x0);
+        return tmp;
+    }
+
+    // Emit an exit towards a statically known address, to be linked to its block later.
+    void exitStatic(const uint16_t to, const uint16_t n) {
+        e.rs({ 0x81 }, 0x0, o_cyc, true); e.d(n); // add qword [cyc], n
+        uint8_t *rel = e.jmp();
+        x64::patch(rel, e.p);
+        e.rs({ 0xc7 }, 0x0, o_r + 2*PC, false, true); e.b(to & 0xff); e.b(to >> 8); // mov word [pc], to
+        e.movi(EAX, exit_link + exits.size());
+        x64::patch(e.jmp(), epilogue);
+        exits.pb({ rel, to });
+    }
+
+    // Emit an exit towards the address held in a host register.
+    void exitDynamic(const uint8_t h, const uint16_t n, const uint16_t code = exit_dyn) {
+        e.rs({ 0x89 }, h, o_r + 2*PC, false, true); // mov word [pc], h
+        e.rs({ 0x81 }, 0x0, o_cyc, true); e.d(n);
+        e.movi(EAX, code);
+        x64::patch(e.jmp(), epilogue);
+    }
+
+    // Emit a write to the output register of the value in edx, through a call to 'jitOut'. Mapped registers the ABI
+    // does not preserve are stored into the machine state around the call.
+    void out() {
+        for (uint8_t s = 0; s < 16; ++s) if (hclobbered(hmap[s])) e.rs({ 0x89 }, hmap[s], o_r + 2*s, false, true); // mov word
+        e.rr({ 0x89 }, EBX, EDI, true); // mov rdi, rbx
+        e.mov(ESI, EDX);
+        e.b(0x48); e.b(0x83); e.b(0xec); e.b(0x08); // sub rsp, 8 (blocks run with rsp 8 bytes off 16)
+        e.b(0x48); e.b(0xb8); e.q((uint64_t)&jitOut); // mov rax, jitOut
+        e.b(0xff); e.b(0xd0); // call rax
+        e.b(0x48); e.b(0x83); e.b(0xc4); e.b(0x08); // add rsp, 8
+        for (uint8_t s = 0; s < 16; ++s) if (hclobbered(hmap[s])) e.rs({ 0x0f, 0xb7 }, hmap[s], o_r + 2*s); // movzx
+    }
+
+    // Emit an EXC microop.
+    void exc(const uint8_t opc, const bool notb, const bool setflags) {
+        uint8_t a = hmap[A], bb = hmap[B], o = hmap[OUT];
+        e.mov(ECX, bb);
+        if (notb) { e.inv(ECX); e.movzx16(ECX, ECX); }
+        if (setflags) {
+            e.lea(EDX, a, ECX, notb); // Adder output
+            e.shi(0x5, EDX, 14); e.alui(0x4, EDX, flg_c); // C
+            e.mov(EAX, a); e.alu(0x31, EAX, ECX); e.inv(EAX); // ~(A^B)
+        }
+        switch (opc) {
+            case ADD: e.lea(o, a, ECX, notb); break;
+            case AND: e.mov(o, a); e.alu(0x21, o, ECX); break;
+            case ORR: e.mov(o, a); e.alu(0x09, o, ECX); break;
+            case EOR: e.mov(o, a); e.alu(0x31, o, ECX); break;
+            case NOT: e.mov(o, a); e.inv(o); break;
+            case LSL: e.alui(0x4, ECX, 0xf); e.mov(o, a); e.shcl(0x4, o); break;
+            case LSR: e.alui(0x4, ECX, 0xf); e.mov(o, a); e.shcl(0x5, o); break;
+            case ASR: e.alui(0x4, ECX, 0xf); e.movsx16(o, a); e.shcl(0x7, o); break;
+        }
+        e.movzx16(o, o);
+        if (setflags) {
+            e.mov(ECX, a); e.alu(0x31, ECX, o); e.alu(0x21, EAX, ECX); e.shi(0x5, EAX, 12); e.alui(0x4, EAX, flg_v); e.alu(0x09, EDX, EAX); // V
+            e.mov(EAX, o); e.shi(0x5, EAX, 15); e.alu(0x09, EDX, EAX); // S
+            e.rr({ 0x85 }, o, o); e.b(0x0f); e.b(0x94); e.b(0xc0); e.rr({ 0x0f, 0xb6 }, EAX, EAX); e.alu(0x01, EAX, EAX); e.alu(0x09, EDX, EAX); // Z
+            e.rs({ 0x88 }, EDX, o_flg); // mov byte [flg], dl
+        }
+    }
+
+    // Translate the block starting at a code segment address.
+    // @return          Block.
+    jblock compile(rc16 &m, const uint16_t start) {
+        if (buf + jit_size - e.p < 64 * 1024) flush();
+        jblock jb;
+        jb.entry = e.p;
+        // Prologue: leave to the dispatcher if the budget cannot cover the whole block
+        e.rs({ 0x8b }, EAX, o_cyc, true); // mov rax, [cyc]
+        e.b(0x48); e.b(0x05); uint8_t *len = e.p; e.d(0); // add rax, len
+        e.rip({ 0x3b }, EAX, lim, true); // cmp rax, [lim]
+        uint8_t *over = e.jcc(0x7); // ja
+        int32_t jr = -1; // Statically known JR value
+        uint16_t pc = start, n = 0;
+        bool done = false;
+        while (!done) {
+            if (n == jit_maxblk || pc > mem_eprg || pc < mem_iprg) { exitStatic(pc, n); break; }
+            uint16_t instr = m.mem[pc];
+            pdop d = predecode(instr);
+            bool al = d.msk == cnd_mask[AL];
+            ++pc; ++n;
+            if (d.msk == 0x0) continue; // Never executed
+            if (d.k == H_LJR) {
+                jr = d.imm;
+                e.rs({ 0xc7 }, 0x0, o_r + 2*JR, false, true); e.b(jr & 0xff); e.b(jr >> 8); // mov word [jr], imm
+                continue;
+            }
+            uint8_t *skip = nullptr;
+            switch (d.k) {
+                case H_NOP: break;
+                case H_HLT: { // Ends the block if taken, staying on the HLT
+                    if (!al) { cond(d.msk); skip = e.jcc(0x3); }
+                    e.rs({ 0xc6 }, 0x0, o_hlt); e.b(0x1); // mov byte [hlt], 1
+                    e.movi(EAX, pc - 1);
+                    exitDynamic(EAX, n);
+                    done = al;
+                    break;
+                }
+                case H_MOVO: case H_LDMO: case H_SETO:
+                    if (!al) { cond(d.msk); skip = e.jcc(0x3); }
+                    if (d.k == H_SETO) e.movi(EDX, d.imm);
+                    else if (d.k == H_LDMO) e.rm({ 0x0f, 0xb7 }, EDX, o_mem);
+                    else { uint8_t v = src(d.a, pc, jr, EDX); if (v != EDX) e.mov(EDX, v); }
+                    out();
+                    break;
+                case H_MOV: case H_LDM: case H_SET: {
+                    if (d.b == r_sink) break;
+                    if (d.b == PC) { // Jump: ends the block
+                        int32_t to = (d.k == H_SET) ? d.imm : (d.k == H_MOV && d.a == JR) ? jr : (d.k == H_MOV && d.a == PC) ? pc : -1;
+                        uint8_t *taken = nullptr;
+                        if (!al) { cond(d.msk); taken = e.jcc(0x2); exitStatic(pc, n); x64::patch(taken, e.p); } // jc
+                        if (to >= 0) exitStatic(to, n);
+                        else {
+                            uint8_t h = EAX;
+                            if (d.k == H_LDM) e.rm({ 0x0f, 0xb7 }, EAX, o_mem);
+                            else h = src(d.a, pc, jr, EAX);
+                            exitDynamic(h, n);
+                        }
+                        done = true;
+                        break;
+                    }
+                    uint8_t dst = hmap[d.b];
+                    if (!al) cond(d.msk);
+                    if (d.k == H_SET) {
+                        if (al) e.movi(dst, d.imm);
+                        else { e.movi(EDX, d.imm); e.cmovc(dst, EDX); }
+                    } else if (d.k == H_LDM) {
+                        if (al) e.rm({ 0x0f, 0xb7 }, dst, o_mem);
+                        else { e.rm({ 0x0f, 0xb7 }, EDX, o_mem); e.cmovc(dst, EDX); }
+                    } else {
+                        uint8_t s = src(d.a, pc, jr, EDX);
+                        if (s == dst) break;
+                        if (al) e.mov(dst, s);
+                        else e.cmovc(dst, s);
+                    }
+                    break;
+                }
+                case H_STM: {
+                    if (!al) { cond(d.msk); skip = e.jcc(0x3); } // jnc
+                    uint8_t s = src(d.a, pc, jr, EDX);
+                    e.rm({ 0x89 }, s, o_mem, true); // mov word [mem+mar*2], s
+                    // Leave if the store hit the code segment
+                    e.mov(EAX, EBP); e.alui(0x0, EAX, (uint32_t)-mem_iprg); e.alui(0x7, EAX, mem_eprg - mem_iprg + 1);
+                    uint8_t *safe = e.jcc(0x3); // jae
+                    e.movi(EAX, pc); exitDynamic(EAX, n, exit_smc);
+                    x64::patch(safe, e.p);
+                    break;
+                }
+                default: // EXC
+                    if (!al) { cond(d.msk); skip = e.jcc(0x3); }
+                    if (d.k == H_EXCF) exc(d.a, d.b, true);
+                    else exc(d.k - H_ADD, d.imm != 0x0, false);
+                    break;
+            }
+            if (skip) x64::patch(skip, e.p);
+        }
+        memcpy(len, &n, 2);
+        // Budget exhausted: hand back to the dispatcher at the start of the block
+        x64::patch(over, e.p);
+        e.movi(EAX, start);
+        exitDynamic(EAX, 0);
+        jb.len = n;
+        return jb;
+    }
+
+    // Look up the block starting at an address, translating it once it is hot.
+    jblock *lookup(rc16 &m, const uint16_t pc) {
+        if (pc < mem_iprg || pc > mem_eprg) return nullptr;
+        jblock *b = &blk[pc - mem_iprg];
+        if (!b->entry && ++hits[pc - mem_iprg] >= jit_hot) {
+            *b = compile(m, pc);
+            if (!b->entry) hits[pc - mem_iprg] = 0;
+        }
+        return b->entry ? b : nullptr;
+    }
+
+    // Verify the machine against the reference interpreter after 'n' more microops.
+    void verify(rc16 &m, const uint16_t from) {
+        run(*ref, m.cyc - ref->cyc);
+        oss err;
+        for (uint8_t s = R0; s <= JR; ++s) if (m.r[s] != ref->r[s]) err << " r" << (int)s << "=" << bin2hex(m.r[s]) << " (expected " << bin2hex(ref->r[s]) << ")";
+        if (m.flg != ref->flg) err << " flags=" << (int)m.flg << " (expected " << (int)ref->flg << ")";
+        if (m.hlt != ref->hlt || m.out != ref->out) err << " halt/output state";
+        if (memcmp(m.mem, ref->mem, sizeof(m.mem)) != 0) err << " memory";
+        if (err.str().length() > 0) throw runtime_error("JIT diverges from the interpreter in block " + bin2hex(from) + ":" + err.str());
+    }
+
+    // Run a machine until it halts or a microop budget runs out.
+    // @param m         Machine.
+    // @param max       Maximum number of microops to execute.
+    // @return          Number of microops executed.
+    uint64_t execute(rc16 &m, const uint64_t max) {
+        uint64_t start = m.cyc, end = (max > UINT64_MAX - m.cyc) ? UINT64_MAX : m.cyc + max; // Saturated: the machine may have run before
+        *lim = end;
+        if (check && !ref) ref = new rc16(m);
+        while (!m.hlt && m.cyc < end) {
+            uint16_t pc = m.r[PC];
+            jblock *b = lookup(m, pc);
+            if (b && m.cyc + b->len <= end) {
+                uint16_t code = enter(&m, b->entry);
+                if (code == exit_smc) flush();
+                else if (code >= exit_link && !check) { // Chain the exit to its target block, if there is one
+                    jexit x = exits[code - exit_link];
+                    uint64_t f = flushes;
+                    jblock *t = lookup(m, x.to);
+                    if (t && f == flushes) x64::patch(x.rel, t->entry);
+                }
+                if (check) verify(m, pc);
+                continue;
+            }
+            // Cold or unsupported code: interpret up to the next control transfer
+            for (int i = 0; i < jit_cold && !m.hlt && m.cyc < end; ++i) {
+                uint16_t p = m.r[PC], instr = m.mem[p];
+                bool smc = (instr & 0xc301) == 0x4300 && m.r[MAR] >= mem_iprg && m.r[MAR] <= mem_eprg; // Store into the code segment
+                step(m);
+                if (smc) flush();
+                if (m.r[PC] != (uint16_t)(p + 1)) break;
+            }
+            if (check) verify(m, pc);
+        }
+        return m.cyc - start;
+    }
+};
+
+#else
+
+// Fallback for hosts the translator does not target: the threaded interpreter.
+struct jit {
+    bool check = false;
+    pdcache dc;
+    uint64_t execute(rc16 &m, const uint64_t max) { return runThreaded(m, max, dc); }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * ===================
+ * RCC - RC16 COMPILER
+ * ===================
+ *
+ * SOURCE LEXER
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef LEX
+#define LEX
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+// Line of a source file: a view of its text (trimmed, case left as it is), and where it starts.
+struct token {
+    string_view s; // Text
+    int line; // Line number (from 1)
+    int col; // Column of the first character (from 1)
+};
+
+// Text of a source file, mapped into memory (files which cannot be mapped, like pipes, are read into a buffer).
+// Tokens of a file are views into its text, so they must not outlive it.
+struct srcfile {
+    string_view text; // Text
+    string buf; // Text, if the file is not mapped
+    void *map = MAP_FAILED; // Mapping
+    size_t len = 0; // Length of the mapping
+
+    // @param file  File name (a missing file reads as empty).
+    srcfile(const string &file) {
+        int fd = open(file.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            len = st.st_size;
+            map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+            if (map != MAP_FAILED) madvise(map, len, MADV_SEQUENTIAL);
+        }
+        if (fd >= 0) close(fd);
+        if (map != MAP_FAILED) text = string_view((const char*)map, len);
+        else {
+            ifs in(file, ios::binary);
+            buf.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+            text = buf;
+        }
+    }
+    srcfile(const srcfile &) = delete;
+    srcfile &operator=(const srcfile &) = delete;
+    ~srcfile() { if (map != MAP_FAILED) munmap(map, len); }
+};
+
+// Split a source text into lines, in a single pass: lines are trimmed (of spaces), and empty lines and comments are
+// skipped.
+// @param text      Source text.
+// @return          Tokens (views into 'text').
+constexpr vector<token> lex(const string_view text) {
+    vector<token> out;
+    int c = 0; // Line counter
+    for (size_t pos = 0, end; pos < text.length(); pos = end + 1) {
+        end = min(text.find('\n', pos), text.length());
+        ++c;
+        size_t b = pos, e = end;
+        while (b < e && text[b] == ' ') ++b;
+        while (e > b && text[e-1] == ' ') --e;
+        if (b == e || text[b] == '#') continue; // Skip empty lines and comments
+        out.pb({ text.substr(b, e - b), c, (int)(b - pos) + 1 });
+    }
+    return out;
+}
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * ===================
+ * RCC - RC16 COMPILER
+ * ===================
+ *
+ * LISTING
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef LST
+#define LST
+
+// Every microop takes one clock cycle, so the static cost of a line is the number of microops it expanded to.
+// Loops are found from their back edges: a 'jmp' (LJR, then MOV JR->PC) to an address not after it, which is not the
+// jump of a CAL. Their cost per iteration is the size of their body, which is exact for straight-line bodies and an
+// upper bound for those which jump forward inside themselves; calls are not included.
+
+// Write the listing of a program: every source line with its address, microops and cost (or words, in the data
+// section), then the size of every label and the cost per iteration of every loop.
+// @param os        Output stream.
+// @param prg       Program (its sources are read again).
+inline void writeLst(ostream &os, const program &prg) {
+    const vector<uint16_t> &code = prg.code;
+    auto name = [&](const uint16_t addr) { // Label at an address, if any
+        for (auto &l : prg.lbl) if (l.second == addr) return "&" + l.first;
+        return string("");
+    };
+    auto where = [&](const size_t i) { return prg.srcs[prg.line[i].first] + ":" + to_string(prg.line[i].second); };
+    os << right;
+    for (size_t m = 0; m < prg.srcs.size(); ++m) {
+        // Microops and data words of every line of the module
+        map<int,vector<size_t>> at, dat;
+        for (size_t i = 0; i < code.size(); ++i) if (prg.line[i].first == m) at[prg.line[i].second].pb(i);
+        for (size_t i = 0; i < prg.dline.size(); ++i) if (prg.dline[i].first == m) dat[prg.dline[i].second].pb(i);
+        os << "; " << prg.srcs[m] << nl << ";" << setw(5) << "addr" << setw(6) << "cost" << "  " << setw(50) << left << "microops" << right << setw(6) << "line" << nl;
+        const rtmod *rt = rtmodule(prg.srcs[m]);
+        ifs fin;
+        iss sin;
+        if (rt) sin.str(string(rt->src)); // Runtime library modules have no file
+        else fin.open(prg.srcs[m]);
+        istream &in = rt ? (istream &)sin : fin;
+        string text;
+        int c = 0; // Line counter
+        size_t next = at.empty() ? code.size() : at.begin()->second[0]; // Offset of the next microop of the module, for labels
+        size_t dnext = dat.empty() ? prg.dat.size() : dat.begin()->second[0]; // Offset of the next data word of the module
+        bool data = false; // In the data section
+        while (getline(in, text)) {
+            ++c;
+            string_view t = trim(text);
+            if (ieq(t, ".data")) data = true;
+            else if (ieq(t, ".prgm")) data = false;
+            auto it = data ? dat.find(c) : at.find(c);
+            if (it == (data ? dat.end() : at.end())) { // Nothing assembled: labels take the address of what follows them
+                if (!t.empty() && t[0] == '&' && data && dnext < prg.dat.size()) os << "  " << bin2hex(mem_idat + dnext) << setw(58) << "";
+                else if (!t.empty() && t[0] == '&' && !data && next < code.size()) os << "  " << bin2hex(mem_iprg + next) << setw(58) << "";
+                else os << setw(64) << "";
+                os << setw(6) << c << "  " << text << nl;
+                continue;
+            }
+            const vector<size_t> &v = it->second;
+            (data ? dnext : next) = v.back() + 1;
+            for (size_t j = 0; j < v.size(); j += 10) { // 10 microops (or words) per row
+                string words = "";
+                for (size_t k = j; k < min(v.size(), j + 10); ++k) words += bin2hex(data ? prg.dat[v[k]] : code[v[k]]) + " ";
+                if (j == 0 && data) os << "  " << bin2hex(mem_idat + v[0]) << setw(6) << ""; // Data costs no cycles
+                else if (j == 0) os << "  " << bin2hex(mem_iprg + v[0]) << setw(6) << v.size();
+                else os << setw(12) << "";
+                os << "  " << setw(50) << left << words << right;
+                if (j == 0) os << setw(6) << c << "  " << text;
+                os << nl;
+            }
+        }
+        os << nl;
+    }
+    // Labels
+    os << "; Labels" << nl << ";  addr  cost  label" << nl;
+    for (size_t i = 0; i < prg.lbl.size(); ++i) {
+        size_t end = (i + 1 < prg.lbl.size()) ? prg.lbl[i+1].second : mem_iprg + code.size();
+        os << "  " << bin2hex(prg.lbl[i].second) << setw(6) << end - prg.lbl[i].second << "  &" << prg.lbl[i].first << nl;
+    }
+    // Loops
+    os << nl << "; Loops" << nl << ";  addr  cost  loop" << nl;
+    for (size_t q = 0; q + 1 < code.size(); ++q) {
+        uint16_t instr = code[q];
+        if ((instr & 0x8000) || !(instr & 0x1)) continue; // Not a LJR
+        size_t t = (instr >> 1) & 0x3fff;
+        if (t > q || (code[q+1] & 0xc3ff) != MOVREG(JR, PC)) continue; // Not a backward jump
+        if (q >= 1 && (code[q-1] & 0xc3ff) == MOVREG(OUT, LR)) continue; // Jump of a CAL
+        bool calls = false;
+        for (size_t i = t; i + 1 < q; ++i) calls = calls || (code[i] & 0xc3ff) == MOVREG(OUT, LR);
+        string lbl = name(mem_iprg + t);
+        os << "  " << bin2hex(mem_iprg + t) << setw(6) << q + 2 - t << "  " << (lbl.empty() ? "" : lbl + ", ") << where(t) << " - " << where(q)
+           << (calls ? " (plus calls)" : "") << nl;
+    }
+    // Sizes
+    os << nl << "; Code: " << code.size() << " of " << mem_istk - mem_iprg << " microops" << nl;
+    os << "; Data: " << prg.dat.size() << " of " << mem_iprg - mem_idat << " words" << nl;
+}
+
+#endif
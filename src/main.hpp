@@ -14,6 +14,8 @@
 #include <fstream>
 #include <algorithm>
 #include <vector>
+#include <array>
+#include <string_view>
 #include <unordered_map>
 #include <stdexcept>
 #include <unistd.h>
@@ -58,6 +60,30 @@ inline bool fexists(const string &file) {
 	return r;
 }
 
+// Name of the file built from another one next to it: its extension is replaced.
+// @param src		Source filename.
+// @param ext		New extension. Default: '.bin'.
+// @return			Built filename.
+inline string binName(const string &src, const string &ext = ".bin") {
+	size_t dot = src.rfind('.'), slash = src.rfind('/');
+	if (dot == string::npos || (slash != string::npos && dot < slash)) dot = src.length();
+	return src.substr(0, dot) + ext;
+}
+
+// Writes 16-bit words as hexadecimal numbers, each one followed by a space.
+// @param os		Output stream.
+// @param w			Words.
+inline void writeHex(ostream &os, const vector<uint16_t> &w) {
+	static const char hexmap[] = "0123456789abcdef";
+	string buf(w.size() * 5, ' ');
+	char *p = &buf[0];
+	for (uint16_t v : w) {
+		p[0] = hexmap[v >> 12]; p[1] = hexmap[(v >> 8) & 0xf]; p[2] = hexmap[(v >> 4) & 0xf]; p[3] = hexmap[v & 0xf];
+		p += 5;
+	}
+	os << buf;
+}
+
 // Converts a binary 16-bit number to its hexadecimal string representation.
 // @param bin		Binary number.
 // @return			Hexadecimal string representation of the number.
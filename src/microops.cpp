@@ -30,38 +30,38 @@
 // @param r1        Source register [4 bits].
 // @param r2        Destination register [4 bits].
 // @param c         Conditional [4 bits]. Default: AL.
-// @return          Hexadecimal string representation of instruction.
-inline string MOVREG(const reg &r1, const reg &r2, const cond &c = AL) {
+// @return          Encoded instruction.
+constexpr uint16_t MOVREG(const reg &r1, const reg &r2, const cond &c = AL) {
     uint16_t instr = 0x4000; // MOV(reg->reg) = 0b01.xxxx.0.xxxx.xxxx.0
     instr |= c << 10; // Add conditional
     if (oreg(r1) || spec(r1)) instr |= r1 << 5; // Add source register
     else throw oreg_err;
     if (ireg(r2)) instr |= r2 << 1; // Add destination register
     else throw ireg_err;
-    return bin2hex(instr);
+    return instr;
 }
 
 // Implement MOV (mem-op) instruction.
 // @param w         Write if set, read otherwise.
 // @param r         Source/destination register (depending on w) [4 bits].
 // @param c         Conditional [4 bits]. Default: AL.
-// @return          Hexadecimal string representation of instruction.
-inline string MOVMEM(const bool &w, const reg &r, const cond &c = AL) {
+// @return          Encoded instruction.
+constexpr uint16_t MOVMEM(const bool &w, const reg &r, const cond &c = AL) {
     uint16_t instr = 0x4200; // MOV (mem-op) = 0b01.xxxx.1.x.xxxx.0000
     instr |= c << 10; // Add conditional
     if (w) instr |= 1 << 8; // Add 'r/w' flag
     if ((w && oreg(r)) || (!w && ireg(r))) instr |= r << 4; // Add source/destination register
     else if (w) throw oreg_err;
     else throw ireg_err;
-    return bin2hex(instr);
+    return instr;
 }
 
 // Implement SET instruction.
 // @param r         Destination register [4 bits].
 // @param val       Immediate value [6 bits].
 // @param c         Conditional [4 bits]. Default: AL.
-// @return          Hexadecimal string representation of instruction.
-inline string SET(const reg &r, const int &val, const cond &c = AL) {
+// @return          Encoded instruction.
+constexpr uint16_t SET(const reg &r, const int &val, const cond &c = AL) {
     uint16_t instr = 0x8000; // SET = 0b01.xxxx.xxxx.xxxxxx
     instr |= c << 10; // Add conditional
     if (ireg(r)) instr |= r << 6; // Add destination register
@@ -69,7 +69,7 @@ inline string SET(const reg &r, const int &val, const cond &c = AL) {
     if (val >= minval && val <= maxval) instr |= val; // Add immediate value
     else if (val >= minval) throw maxval_err;
     else throw minval_err;
-    return bin2hex(instr);
+    return instr;
 }
 
 // Implement EXC instruction.
@@ -77,43 +77,43 @@ inline string SET(const reg &r, const int &val, const cond &c = AL) {
 // @param notb      ALU '~B' flag [1 bit].
 // @param setflags  ALU 'set flags' flag [1 bit].
 // @param c         Conditional [4 bits]. Default: AL.
-// @return          Hexadecimal string representation of instruction.
-inline string EXC(const alu_op &opcode, const bool &notb, const bool &setflags, const cond &c = AL) {
+// @return          Encoded instruction.
+constexpr uint16_t EXC(const alu_op &opcode, const bool &notb, const bool &setflags, const cond &c = AL) {
     uint16_t instr = 0xc000; // EXC = 0b11.xxxx.xxx.x.x.00000
     instr |= c << 10; // Add conditional
     instr |= opcode << 7; // Add ALU op-code
     if (notb) instr |= 1 << 6; // Add '~B' flag
     if (setflags) instr |= 1 << 5; // Add 'set flags' flag
-    return bin2hex(instr);
+    return instr;
 }
 
 // Implement LJR instruction.
 // @param addr      Address to load to the jump register (offset based on start of code segment) [14 bits].
-// @return          Hexadecimal string representation of instruction.
-inline string LJR(const uint16_t &addr) {
+// @return          Encoded instruction.
+constexpr uint16_t LJR(const uint16_t &addr) {
     uint16_t instr = 0x1; // JMP = 0b0.xxxxxxxxxxxxxx.1
     if (addr < minjmp) throw minjmp_err;
     else if (addr > maxjmp) throw maxjmp_err;
     instr |= addr << 1; // Add offset inside code segment
-    return bin2hex(instr);
+    return instr;
 }
 
 // Implement NOP instruction.
 // @param c         Conditional [4 bits]. Default: AL.
-// @return          Hexadecimal string representation of instruction.
-inline string NOP(const cond &c = AL) {
+// @return          Encoded instruction.
+constexpr uint16_t NOP(const cond &c = AL) {
     uint16_t instr = 0x0; // NOP = 0b00.xxxx.000000000.0
     instr |= c << 10; // Add conditional
-    return bin2hex(instr);
+    return instr;
 }
 
 // Implement HLT instruction.
 // @param c         Conditional [4 bits]. Default: AL.
-// @return          Hexadecimal string representation of instruction.
-inline string HLT(const cond &c = AL) {
+// @return          Encoded instruction.
+constexpr uint16_t HLT(const cond &c = AL) {
     uint16_t instr = 0x200; // HLT = 0b00.xxxx.1.000000000
     instr |= c << 10; // Add conditional
-    return bin2hex(instr);
+    return instr;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+/**
+ * ===================
+ * RCC - RC16 COMPILER
+ * ===================
+ *
+ * RELOCATABLE OBJECTS
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef OBJ
+#define OBJ
+
+// Object file format (text, one record per line):
+//   rco                                Header
+//   src <file>                         Source filename
+//   dat <n>                            Data section size, followed by a line with its words (hexadecimal)
+//   prg <n>                            Code size, followed by a line with its microops (hexadecimal)
+//   pin <at> <n>                       Microops [at, at+n) must survive optimization
+//   lin <at> <n> <line>                Microops [at, at+n) come from a source line
+//   lid <at> <n> <line>                Data words [at, at+n) come from a source line
+//   lbd <addr> <label>                 Label in .data section
+//   lbp <addr> <label>                 Label in .prgm section
+//   ljr <at> <line> <label>            LJR at 'at' jumps to a label
+//   put <at> <line> <r> <c> <label>    Fixed-length PUT sequence from 'at' loads a label into 'r' under condition 'c'
+// Numbers are decimal, addresses and words hexadecimal.
+
+// Write a module to an object file.
+// @param os        Output stream.
+// @param obj       Module.
+inline void writeObj(ostream &os, const object &obj) {
+    os << "rco" << nl << "src " << obj.src << nl;
+    os << "dat " << obj.dat.size() << nl;
+    writeHex(os, obj.dat);
+    os << nl << "prg " << obj.code.size() << nl;
+    writeHex(os, obj.code);
+    os << nl;
+    for (size_t i = 0, j; i < obj.pin.size(); i = j) { // Runs of pinned microops
+        for (j = i; j < obj.pin.size() && obj.pin[j] == obj.pin[i]; ++j);
+        if (obj.pin[i]) os << "pin " << i << " " << j - i << nl;
+    }
+    for (size_t i = 0, j; i < obj.line.size(); i = j) { // Runs of microops from the same line
+        for (j = i; j < obj.line.size() && obj.line[j] == obj.line[i]; ++j);
+        os << "lin " << i << " " << j - i << " " << obj.line[i] << nl;
+    }
+    for (size_t i = 0, j; i < obj.dline.size(); i = j) { // Runs of data words from the same line
+        for (j = i; j < obj.dline.size() && obj.dline[j] == obj.dline[i]; ++j);
+        os << "lid " << i << " " << j - i << " " << obj.dline[i] << nl;
+    }
+    for (auto &l : obj.d_lbl) os << "lbd " << bin2hex(l.second) << " " << l.first << nl;
+    for (auto &l : obj.p_lbl) os << "lbp " << bin2hex(l.second) << " " << l.first << nl;
+    for (const fixup &f : obj.fix) {
+        if (f.kind == fix_ljr) os << "ljr " << f.at << " " << f.line << " " << f.lbl << nl;
+        else os << "put " << f.at << " " << f.line << " " << (int)f.r << " " << (int)f.c << " " << f.lbl << nl;
+    }
+}
+
+// Read a module from an object file.
+// @param file      Object filename.
+// @return          Module.
+inline object readObj(const string &file) {
+    ifs in(file);
+    if (!in) throw invalid_argument("Given object does not exist or is unaccessible.");
+    string line;
+    if (!getline(in, line) || line.compare("rco") != 0) throw invalid_argument("Not an RC16 object.");
+    object obj;
+    auto words = [&](vector<uint16_t> &w, const size_t n) {
+        w.resize(n);
+        if (!getline(in, line)) throw invalid_argument("Truncated object.");
+        iss ls(line);
+        for (uint16_t &v : w) if (!(ls >> hex >> v)) throw invalid_argument("Truncated object.");
+    };
+    int c = 1; // Line counter
+    while (getline(in, line)) {
+        ++c;
+        iss ls(line);
+        string rec, lbl;
+        size_t at, n;
+        int ln, r, cd;
+        ls >> rec;
+        bool ok = true;
+        if (rec.compare("src") == 0) ok = (bool)getline(ls >> ws, obj.src);
+        else if (rec.compare("dat") == 0) { ok = (bool)(ls >> n); if (ok) { words(obj.dat, n); ++c; obj.dline.resize(n, 0); } }
+        else if (rec.compare("prg") == 0) { ok = (bool)(ls >> n); if (ok) { words(obj.code, n); ++c; obj.pin.resize(n, false); obj.line.resize(n, 0); } }
+        else if (rec.compare("pin") == 0) {
+            ok = (ls >> at >> n) && at + n <= obj.pin.size();
+            if (ok) fill(obj.pin.begin() + at, obj.pin.begin() + at + n, true);
+        } else if (rec.compare("lin") == 0 || rec.compare("lid") == 0) {
+            vector<int> &l = (rec[2] == 'n') ? obj.line : obj.dline;
+            ok = (ls >> at >> n >> ln) && at + n <= l.size();
+            if (ok) fill(l.begin() + at, l.begin() + at + n, ln);
+        } else if (rec.compare("lbd") == 0 || rec.compare("lbp") == 0) {
+            uint16_t addr;
+            ok = (bool)(ls >> hex >> addr >> ws) && getline(ls, lbl);
+            if (ok) (rec[2] == 'd' ? obj.d_lbl : obj.p_lbl)[lbl] = addr;
+        } else if (rec.compare("ljr") == 0) {
+            ok = (ls >> at >> ln >> ws) && getline(ls, lbl) && at < obj.code.size();
+            if (ok) obj.fix.pb({ at, lbl, fix_ljr, PC, AL, ln });
+        } else if (rec.compare("put") == 0) {
+            ok = (ls >> at >> ln >> r >> cd >> ws) && getline(ls, lbl) && at + putlen <= obj.code.size() && r <= JR && cd <= CC;
+            if (ok) obj.fix.pb({ at, lbl, fix_put, (reg)r, (cond)cd, ln });
+        } else ok = rec.empty();
+        if (!ok) throw invalid_argument("Malformed object record on line " + to_string(c) + ".");
+    }
+    return obj;
+}
+
+#endif
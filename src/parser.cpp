@@ -11,314 +11,1257 @@
 #ifndef PAR
 #define PAR
 
-// Trim a string.
+#include <deque>
+
+// Trim a string (of spaces).
 // @param s		String.
-// @return		Trimmed string.
-inline string trim(const string &s) {
-	string t = s;
-	while (t[0] == ' ') t = t.substr(1);
-	while (t[t.length()-1] == ' ') t = t.substr(0, t.length()-1);
-	return t;
+// @return		Trimmed string (a view into 's').
+constexpr string_view trim(string_view s) {
+	size_t b = 0, e = s.length();
+	while (b < e && s[b] == ' ') ++b;
+	while (e > b && s[e-1] == ' ') --e;
+	return s.substr(b, e - b);
 }
 
 // Transform a string to lowercase.
 // @param s		String.
 // @return		Lowercase string.
-inline string lc(const string &s) {
-	string t = "";
-	for (char c : s) t += std::tolower(c);
+constexpr string lc(const string_view s) {
+	string t(s);
+	for (char &c : t) if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
 	return t;
 }
 
+// Check whether two strings are equal, ignoring case.
+// @param a		String.
+// @param b		String (lowercase).
+// @return		True if they are equal.
+constexpr bool ieq(const string_view a, const string_view b) {
+	if (a.length() != b.length()) return false;
+	for (size_t i = 0; i < a.length(); ++i) if ((a[i] >= 'A' && a[i] <= 'Z' ? a[i] - 'A' + 'a' : a[i]) != b[i]) return false;
+	return true;
+}
+
 // Split a string basing on a certain delim character.
 // @param s			String to be split.
 // @param delim		Delimitator.
-// @return			Vector of split strings.
-inline vector<string> split(const string &s, const char &delim) {
-	vector<string> out;
-	int ptr = 0;
-	if (s.length() > 0) out.pb("");
-	for (int i = 0; i < s.length(); ++i) {
-		if (s[i] == delim && i < s.length()) {
-			out.pb("");
-			++ptr;
-		} else if (s[i] != delim) out[ptr] += s[i];
+// @return			Vector of split strings (views into 's').
+constexpr vector<string_view> split(const string_view s, const char &delim) {
+	vector<string_view> out;
+	if (s.empty()) return out;
+	for (size_t pos = 0, end = 0; end < s.length(); pos = end + 1) {
+		end = min(s.find(delim, pos), s.length());
+		out.pb(s.substr(pos, end - pos));
 	}
 	return out;
 }
 
+// Pack a name of up to 3 characters into an integer, so that names can be switched on. Case is ignored.
+// @param s		Name.
+// @param n		Name length.
+// @return		Packed name, lowercase (0xffffffff for longer names, which are never valid).
+constexpr uint32_t pk(const char *s, const size_t n) {
+	uint32_t p = 0;
+	if (n > 3) return 0xffffffff;
+	for (size_t i = 0; i < n; ++i) p |= (uint32_t)(uint8_t)(s[i] >= 'A' && s[i] <= 'Z' ? s[i] - 'A' + 'a' : s[i]) << (8*i);
+	return p;
+}
+constexpr uint32_t operator"" _pk(const char *s, const size_t n) { return pk(s, n); }
+constexpr uint32_t pk(const string_view s) { return pk(s.data(), s.length()); }
+
 // Convert string conditional to cond.
 // @param c		String conditional.
 // @return		Integer conditional.
-inline cond condition(const string &c) {
-	unordered_map<string,cond> m;
-	m["al"] = AL; m["eq"] = EQ; m["ne"] = NE; m["lt"] = LT; m["le"] = LE; m["gt"] = GT; m["ge"] = GE; m["vs"] = VS; m["vc"] = VC; m["cs"] = CS; m["cc"] = CC;
-	return m[c];
+constexpr cond condition(const string_view c) {
+	switch (pk(c)) {
+		case "al"_pk: return AL; case "eq"_pk: return EQ; case "ne"_pk: return NE; case "lt"_pk: return LT; case "le"_pk: return LE; case "gt"_pk: return GT;
+		case "ge"_pk: return GE; case "vs"_pk: return VS; case "vc"_pk: return VC; case "cs"_pk: return CS; case "cc"_pk: return CC;
+		default: throw invalid_argument("Invalid condition '" + string(c) + "'.");
+	}
 }
 
 // Convert string register to reg.
 // @param r     String register.
 // @return      Integer register.
-inline reg regst(const string &r) {
-    unordered_map<string,reg> m;
-    m["r0"] = R0; m["r1"] = R1; m["r2"] = R2; m["r3"] = R3; m["r4"] = R4; m["r5"] = R5; m["sp"] = SP; m["r6"] = R6; m["lr"] = LR; m["r7"] = R7; m["pc"] = PC;
-    m["a"] = A; m["b"] = B; m["out"] = OUT; m["mar"] = MAR; m["or"] = OR; m["jr"] = JR;
-    return m[r];
+constexpr reg regst(const string_view r) {
+    switch (pk(r)) {
+        case "r0"_pk: return R0; case "r1"_pk: return R1; case "r2"_pk: return R2; case "r3"_pk: return R3; case "r4"_pk: return R4; case "r5"_pk: return R5;
+        case "sp"_pk: return SP; case "r6"_pk: return R6; case "lr"_pk: return LR; case "r7"_pk: return R7; case "pc"_pk: return PC;
+        case "a"_pk: return A; case "b"_pk: return B; case "out"_pk: return OUT; case "mar"_pk: return MAR; case "or"_pk: return OR; case "jr"_pk: return JR;
+        default: throw invalid_argument("Invalid register '" + string(r) + "'.");
+    }
 }
 
-// Compute number of microops needed to perform an instruction.
-// @param instr		Line of code.
-// @return			Number of microops.
-inline int nom(const string &line, unordered_map<string,uint16_t> &d_lbl) {
-	int c = 0;
-    // Parse command
-    string instr = line.substr(0, 3); // Instruction
-    bool s = false; // 's' flag (used for ALU operations)
-    cond cnd = AL; // Conditional
-    if (line[3] == 's') {
-        s = true;
-        if (line[4] != ' ') cnd = condition(line.substr(4, 6));
-    } else {
-        if (line[3] != ' ') cnd = condition(line.substr(3, 5));
-    }
-    // Parse arguments
-    vector<string> tmp = split(line, ':'), args;
-    if (tmp.size() > 1) {
-        tmp[1] = trim(tmp[1]);
-        args = split(tmp[1], ',');
-        for (string &arg : args) arg = trim(arg);
-    }
-	// Complex commands
-	if (instr.compare("put") == 0) {
-		uint16_t addr = d_lbl[args[1].substr(1)], a1 = addr >> 12, a2 = (addr >> 6) & 0x3f, a3 = addr & 0x3f;
-		if (a1 != 0x0) c += 3;
-		if (a2 != 0x0) c += 3;
-		if (a1 != 0x0 || a2 != 0x0) c += 3;
-		if (a3 != 0x0) c += 2;
-		c += 2;
-	// Four/seven-microop commands
-	} else if (instr.compare("add") == 0 || instr.compare("sub") == 0 || instr.compare("and") == 0 || instr.compare("orr") == 0 || instr.compare("eor") == 0 || instr.compare("lsl") == 0 || instr.compare("lsr") == 0 || instr.compare("asr") == 0) {
-		if (s && cnd != AL) c += 3;
-		c += 4;
-    // Six-microop commands
-    } else if (instr.compare("psh") == 0 || instr.compare("pop") == 0 || instr.compare("cal") == 0) c += 6;
-    // Three-microop commands
-	else if (instr.compare("cmp") == 0) c += 3;
-	// Two-microop commands
-	else if (instr.compare("ldr") == 0 || instr.compare("str") == 0 || instr.compare("jmp") == 0) c += 2;
-	// One-microop commands
-	else if (instr.compare("set") == 0 || instr.compare("mov") == 0 || instr.compare("prt") == 0 || instr.compare("ret") == 0 || instr.compare("nop") == 0 || instr.compare("hlt") == 0) ++c;
-	// Unknown command
-	else throw invalid_argument("Unknown instruction.");
-	return c;
+// Convert the arguments of PSH and POP to registers: a single register, or a list of them in braces.
+// @param args      Arguments ('<reg>', or '{<reg>', ..., '<reg>}').
+// @param multi     Set if the registers are a list.
+// @return          Registers.
+constexpr vector<reg> reglist(const vector<string_view> &args, bool &multi) {
+    if (args.empty()) throw invalid_argument("Too few arguments.");
+    multi = args[0].starts_with('{');
+    if (!multi) {
+        if (args.size() > 1) throw invalid_argument("Too many arguments.");
+        return { regst(args[0]) };
+    }
+    if (!args.back().ends_with('}')) throw invalid_argument("Invalid register list.");
+    vector<reg> rs;
+    for (size_t i = 0; i < args.size(); ++i) {
+        string_view r = args[i];
+        if (i == 0) r = r.substr(1);
+        if (i + 1 == args.size()) r = r.substr(0, r.length() - 1);
+        rs.pb(regst(trim(r)));
+    }
+    return rs;
 }
 
-// Parse a single line of code (a single command)
-// @param line      Line of code.
-// @return          Corresponding command.
-inline string parseLine(const string &line, unordered_map<string,uint16_t> &d_lbl, unordered_map<string,uint16_t> &p_lbl) {
-    oss os;
-    string instr = line.substr(0, 3); // Instruction
+// Convert string mnemonic to its packed form.
+// @param m     String mnemonic.
+// @return      Packed mnemonic (see 'pk').
+constexpr uint32_t mnemonic(const string_view m) {
+    switch (pk(m)) {
+        case "put"_pk: case "set"_pk: case "mov"_pk: case "ldr"_pk: case "str"_pk: case "add"_pk: case "sub"_pk: case "and"_pk: case "orr"_pk:
+        case "eor"_pk: case "lsl"_pk: case "lsr"_pk: case "asr"_pk: case "prt"_pk: case "cmp"_pk: case "jmp"_pk: case "psh"_pk: case "pop"_pk:
+        case "cal"_pk: case "ret"_pk: case "nop"_pk: case "hlt"_pk: case "mli"_pk:
+            return pk(m);
+        default: throw invalid_argument("Unknown instruction.");
+    }
+}
+
+// Line of code, split into its parts.
+struct command {
+    uint32_t m; // Mnemonic (packed)
     bool s = false; // 's' flag (used for ALU operations)
     cond c = AL; // Conditional
-    if (line[3] == 's') {
-        s = true;
-        if (line[4] != ' ') c = condition(line.substr(4, 2));
-    } else {
-        if (line[3] != ' ') c = condition(line.substr(3, 2));
-    }
-    // Parse arguments
-    vector<string> tmp = split(line, ':'), args;
-    if (tmp.size() > 1) {
-        tmp[1] = trim(tmp[1]);
-        args = split(tmp[1], ',');
-        for (string &arg : args) arg = trim(arg);
+    vector<string_view> args; // Arguments (views into the line)
+};
+
+// Split a line of code into mnemonic, flags, conditional and arguments.
+// @param line      Line of code ('<mnemonic>[s][<cond>][: <arg>, ...]'), in any case.
+// @return          Command (its arguments are views into 'line').
+constexpr command parseCmd(const string_view line) {
+    command cmd;
+    size_t colon = min(line.find(':'), line.length());
+    string_view head = trim(line.substr(0, colon));
+    cmd.m = mnemonic(head.substr(0, 3));
+    string_view sfx = head.substr(min((size_t)3, head.length()));
+    if (sfx.length() > 0 && (sfx[0] == 's' || sfx[0] == 'S')) { cmd.s = true; sfx = sfx.substr(1); }
+    if (sfx.length() > 0) cmd.c = condition(sfx);
+    // Parse arguments (up to the next colon, if any)
+    if (colon < line.length()) {
+        string_view tail = line.substr(colon + 1);
+        cmd.args = split(trim(tail.substr(0, tail.find(':'))), ',');
+        for (string_view &arg : cmd.args) arg = trim(arg);
     }
+    return cmd;
+}
+
+// Convert a number to its value at compile time, like 'stoi' does: an optional sign and as many digits as possible.
+// @param s         Number.
+// @param base      Base (10 or 16, with or without '0x' prefix).
+// @return          Value.
+constexpr int cnum(const string_view s, const int base) {
+    size_t i = 0, i0;
+    bool neg = false;
+    if (i < s.length() && (s[i] == '-' || s[i] == '+')) neg = s[i++] == '-';
+    if (base == 16 && i + 1 < s.length() && s[i] == '0' && (s[i+1] == 'x' || s[i+1] == 'X')) i += 2;
+    int v = 0;
+    for (i0 = i; i < s.length(); ++i) {
+        char l = (s[i] >= 'A' && s[i] <= 'Z') ? s[i] - 'A' + 'a' : s[i];
+        int d = (l >= '0' && l <= '9') ? l - '0' : (l >= 'a' && l <= 'f') ? l - 'a' + 10 : base;
+        if (d >= base) break;
+        v = v * base + d;
+    }
+    if (i == i0) throw invalid_argument("Invalid value '" + string(s) + "'.");
+    return neg ? -v : v;
+}
+
+// Value of a label, for expressions.
+// @param lbl       Labels addresses (by lowercase name).
+// @return          Function giving the address of a label from its name, throwing if it is not known.
+template <class lblmap>
+constexpr auto lblval(lblmap &lbl) {
+    return [&lbl](const string_view name) -> int64_t {
+        string l = lc(name);
+        if (lbl.find(l) == lbl.end()) throw invalid_argument("Invalid label.");
+        return lbl[l];
+    };
+}
+
+// Check whether an immediate argument refers to a label which is not known (yet).
+// @param arg       Argument.
+// @param lbl       Labels addresses (by lowercase name).
+// @return          True if some label it refers to is not in 'lbl'.
+template <class lblmap>
+constexpr bool unknown(const string_view arg, lblmap &lbl) {
+    if (!isexpr(arg)) return arg.starts_with('$') && lbl.find(lc(arg.substr(1))) == lbl.end();
+    for (size_t i = arg.find('$'); i != string_view::npos; i = arg.find('$', i + 1)) if (lbl.find(lc(arg.substr(i + 1, lbllen(arg.substr(i + 1))))) == lbl.end()) return true;
+    return false;
+}
+
+// Label a fixup refers to: the name of a label, or an expression of labels (starting with '$' or holding one).
+// @param arg       Argument.
+// @return          Fixup label.
+constexpr string fixlbl(const string_view arg) {
+    if (arg.starts_with('$') && !isexpr(arg)) return lc(arg.substr(1));
+    return lc(arg);
+}
+
+// Value of the label, or expression of labels, of a fixup.
+// @param lbl       Fixup label (see 'fixlbl').
+// @param val       Function giving the value of a label from its name (lowercase), throwing if it is not known.
+// @return          Value.
+template <class lookup>
+constexpr uint16_t fixval(const string &lbl, const lookup &val) {
+    if (lbl.find('$') == string::npos) return val(lbl);
+    return (uint16_t)eval(lbl, val);
+}
+
+// Convert an immediate argument (label, hexadecimal or decimal value, or an expression of them) to its value.
+// @param arg       Argument.
+// @param lbl       Labels addresses (by lowercase name).
+// @return          Value.
+template <class lblmap>
+constexpr uint16_t immval(const string_view arg, lblmap &lbl) {
+    if (isexpr(arg)) return (uint16_t)eval(arg, lblval(lbl)); // Expression
+    if (arg.starts_with('$')) { // Label
+        string l = lc(arg.substr(1));
+        if (lbl.find(l) == lbl.end()) throw invalid_argument("Invalid label.");
+        return lbl[l];
+    } else if (arg.length() > 1 && (arg[1] == 'x' || arg[1] == 'X')) return (uint16_t)(is_constant_evaluated() ? cnum(arg, 16) : stoi(string(arg), 0, 16)); // Hexadecimal address
+    return (uint16_t)(is_constant_evaluated() ? cnum(arg, 10) : atoi(string(arg).c_str())); // Decimal address
+}
+
+// Update the known contents of R0..R7 after a line of code, so that PUT can build constants out of them.
+// Only PUT and SET make a register known; every other write, and any call, makes it unknown.
+// @param line      Line of code.
+// @param d_lbl     Labels addresses (in .data section).
+// @param known     Known register contents (modified).
+inline void track(const string_view line, unordered_map<string,uint16_t> &d_lbl, regvals &known) {
+    command cmd;
+    try {
+        cmd = parseCmd(line);
+        switch (cmd.m) {
+            case "cal"_pk: known.clear(); break;
+            case "psh"_pk: known.forget(SP); break;
+            case "pop"_pk: {
+                bool multi;
+                known.forget(SP);
+                for (reg r : reglist(cmd.args, multi)) known.forget(r);
+                break;
+            }
+            case "str"_pk: case "cmp"_pk: case "prt"_pk: case "jmp"_pk: case "ret"_pk: case "nop"_pk: case "hlt"_pk: break;
+            default:
+                if (cmd.args.size() == 0) break;
+                known.forget(regst(cmd.args[0]));
+                if (cmd.c == AL && cmd.args.size() > 1 && (cmd.m == "put"_pk || cmd.m == "set"_pk)) known.set(regst(cmd.args[0]), immval(cmd.args[1], d_lbl));
+        }
+    } catch (invalid_argument &e) {} // Invalid lines have been reported by the parser already
+}
+
+// Unresolved reference to a label, patched once every label is known.
+struct fixup {
+    size_t at; // Index of the patched microop (fix_ljr) or of the first microop of the sequence (fix_put) in the code buffer
+    string lbl; // Label
+    uint8_t kind; // fix_ljr or fix_put
+    reg r; // Destination register (fix_put)
+    cond c; // Conditional (fix_put)
+    int line; // Source line
+};
+#define fix_ljr     0x0 // LJR of a JMP or CAL
+#define fix_put     0x1 // Fixed-length PUT (or SET) sequence
+
+// Parse a single line of code (a single command)
+// @param line      Line of code.
+// @param d_lbl     Labels addresses (in .data section).
+// @param p_lbl     Labels addresses (in .prgm section).
+// @param known     Known register contents before the instruction.
+// @param o         Code buffer (the command is appended to it).
+// @param fix       Fixups (labels which are not known yet, and code labels in PUT and SET, are appended to it).
+template <class lblmap>
+constexpr void parseLine(const string_view line, lblmap &d_lbl, lblmap &p_lbl, const regvals &known, vector<uint16_t> &o, vector<fixup> &fix) {
+    command cmd = parseCmd(line);
+    const vector<string_view> &args = cmd.args;
+    const bool &s = cmd.s;
+    const cond &c = cmd.c;
     // Decode instruction
-    if (instr.compare("put") == 0) { // PUT instruction
-        if (args.size() < 2) throw invalid_argument("Too few arguments.");
-        uint16_t imm_val;
-        if (args[1][0] == '$') { // Label
-            if (d_lbl.find(args[1].substr(1)) == d_lbl.end()) throw invalid_argument("Invalid label.");
-            imm_val = d_lbl[args[1].substr(1)];
-        } else if (args[1][1] == 'x') imm_val = (uint16_t)stoi(args[1], 0, 16); // Hexadecimal address
-        else imm_val = (uint16_t)atoi(args[1].c_str()); // Decimal address
-        os << put(regst(args[0]), imm_val, c);
-    } else if (instr.compare("set") == 0) { // SET instruction
-        if (args.size() < 2) throw invalid_argument("Too few arguments.");
-        int imm_val;
-        if (args[1][0] == '$') { // Label
-            if (d_lbl.find(args[1].substr(1)) == d_lbl.end()) throw invalid_argument("Invalid label.");
-            imm_val = d_lbl[args[1].substr(1)];
-        } else if (args[1][1] == 'x') imm_val = (uint16_t)stoi(args[1], 0, 16); // Hexadecimal address
-        else imm_val = (uint16_t)atoi(args[1].c_str()); // Decimal address
-        try {
-            os << set(regst(args[0]), imm_val, c);
-        } catch (invalid_argument &e) {
-            throw e;
-        } catch (out_of_range &e) {
-            throw e;
-        }
-    } else if (instr.compare("mov") == 0) { // MOV instruction
-        if (args.size() < 2) throw invalid_argument("Too few arguments.");
-        os << mov(regst(args[1]), regst(args[0]), c);
-    } else if (instr.compare("ldr") == 0) { // LDR instruction
-        if (args.size() < 2) throw invalid_argument("Too few arguments.");
-        os << ldr(regst(args[0]), regst(args[1]), c);
-    } else if (instr.compare("str") == 0) { // STR instruction
-        if (args.size() < 2) throw invalid_argument("Too few arguments.");
-        os << str(regst(args[1]), regst(args[0]), c);
-    } else if (instr.compare("add") == 0) { // ADD instruction
-        if (args.size() < 3) throw invalid_argument("Too few arguments.");
-        os << add(regst(args[1]), regst(args[2]), regst(args[0]), s, c);
-    } else if (instr.compare("sub") == 0) { // SUB instruction
-        if (args.size() < 3) throw invalid_argument("Too few arguments.");
-        os << sub(regst(args[1]), regst(args[2]), regst(args[0]), s, c);
-    } else if (instr.compare("and") == 0) { // AND instruction
-        if (args.size() < 3) throw invalid_argument("Too few arguments.");
-        os << _and(regst(args[1]), regst(args[2]), regst(args[0]), s, c);
-    } else if (instr.compare("orr") == 0) { // ORR instruction
-        if (args.size() < 3) throw invalid_argument("Too few arguments.");
-        os << orr(regst(args[1]), regst(args[2]), regst(args[0]), s, c);
-    } else if (instr.compare("eor") == 0) { // EOR instruction
-        if (args.size() < 3) throw invalid_argument("Too few arguments.");
-        os << eor(regst(args[1]), regst(args[2]), regst(args[0]), s, c);
-    } else if (instr.compare("lsl") == 0) { // LSL instruction
-        if (args.size() < 3) throw invalid_argument("Too few arguments.");
-        os << lsl(regst(args[1]), regst(args[2]), regst(args[0]), s, c);
-    } else if (instr.compare("lsr") == 0) { // LSR instruction
-        if (args.size() < 3) throw invalid_argument("Too few arguments.");
-        os << lsr(regst(args[1]), regst(args[2]), regst(args[0]), s, c);
-    } else if (instr.compare("asr") == 0) { // ASR instruction
-        if (args.size() < 3) throw invalid_argument("Too few arguments.");
-        os << asr(regst(args[1]), regst(args[2]), regst(args[0]), s, c);
-    } else if (instr.compare("prt") == 0) { // PRT instruction
-        if (args.size() < 1) throw invalid_argument("Too few arguments.");
-        os << prt(regst(args[0]), c);
-    } else if (instr.compare("cmp") == 0) { // CMP instruction
-        if (args.size() < 2) throw invalid_argument("Too few arguments.");
-        os << cmp(regst(args[0]), regst(args[1]), c);
-    } else if (instr.compare("jmp") == 0) { // JMP instruction
-        if (args.size() < 1) invalid_argument("Too few arguments.");
-        uint16_t addr;
-        if (args[0][0] == '$') { // Label
-            if (p_lbl.find(args[0].substr(1)) == p_lbl.end()) throw invalid_argument("Invalid label.");
-            addr = p_lbl[args[0].substr(1)];
-        } else if (args[0][1] == 'x') addr = (uint16_t)stoi(args[0], 0, 16); // Hexadecimal address
-        else addr = (uint16_t)atoi(args[0].c_str()); // Decimal address
-        addr -= mem_iprg; // 'addr' is an offset inside code segment
-        try {
-            os << jmp(addr, c);
-        } catch (out_of_range &e) {
-            throw e;
+    if ((cmd.m == "put"_pk || cmd.m == "set"_pk) && args.size() >= 2 && unknown(args[1], d_lbl)) {
+        // Code label or data label not defined yet: fixed-length PUT, patched later
+        fix.pb({ o.size(), fixlbl(args[1]), fix_put, regst(args[0]), c, 0 });
+        putfixed(o, regst(args[0]), 0x0, c);
+        return;
+    }
+    switch (cmd.m) {
+        case "put"_pk: { // PUT instruction
+            if (args.size() < 2) throw invalid_argument("Too few arguments.");
+            put(o, regst(args[0]), immval(args[1], d_lbl), c, known);
+            break;
         }
-    } else if (instr.compare("psh") == 0) { // PSH instruction
-        if (args.size() < 1) throw invalid_argument("Too few arguments.");
-        try {
-            os << psh(regst(args[0]), c);
-        } catch (invalid_argument &e) {
-            throw e;
+        case "set"_pk: { // SET instruction
+            if (args.size() < 2) throw invalid_argument("Too few arguments.");
+            try {
+                set(o, regst(args[0]), immval(args[1], d_lbl), c, known);
+            } catch (invalid_argument &e) {
+                throw e;
+            } catch (out_of_range &e) {
+                throw e;
+            }
+            break;
         }
-    } else if (instr.compare("pop") == 0) { // POP instruction
-        if (args.size() < 1) throw invalid_argument("Too few arguments.");
-        try {
-            os << pop(regst(args[0]), c);
-        } catch (invalid_argument &e) {
-            throw e;
-        }
-    } else if (instr.compare("cal") == 0) { // CAL instruction
-        if (args.size() < 1) throw invalid_argument("Too few arguments.");
-        uint16_t addr;
-        if (args[0][0] == '$') { // Label
-            if (p_lbl.find(args[0].substr(1)) == p_lbl.end()) throw invalid_argument("Invalid label.");
-            addr = p_lbl[args[0].substr(1)];
-        } else if (args[0][1] == 'x') addr = (uint16_t)stoi(args[0], 0, 16); // Hexadecimal address
-        else addr = (uint16_t)atoi(args[0].c_str()); // Decimal address
-        addr -= mem_iprg; // 'addr' is an offset inside code segment
+        case "mov"_pk: { // MOV instruction
+            if (args.size() < 2) throw invalid_argument("Too few arguments.");
+            mov(o, regst(args[1]), regst(args[0]), c);
+            break;
+        }
+        case "ldr"_pk: { // LDR instruction
+            if (args.size() < 2) throw invalid_argument("Too few arguments.");
+            ldr(o, regst(args[0]), regst(args[1]), c);
+            break;
+        }
+        case "str"_pk: { // STR instruction
+            if (args.size() < 2) throw invalid_argument("Too few arguments.");
+            str(o, regst(args[1]), regst(args[0]), c);
+            break;
+        }
+        case "add"_pk: { // ADD instruction
+            if (args.size() < 3) throw invalid_argument("Too few arguments.");
+            add(o, regst(args[1]), regst(args[2]), regst(args[0]), s, c);
+            break;
+        }
+        case "sub"_pk: { // SUB instruction
+            if (args.size() < 3) throw invalid_argument("Too few arguments.");
+            sub(o, regst(args[1]), regst(args[2]), regst(args[0]), s, c);
+            break;
+        }
+        case "and"_pk: { // AND instruction
+            if (args.size() < 3) throw invalid_argument("Too few arguments.");
+            _and(o, regst(args[1]), regst(args[2]), regst(args[0]), s, c);
+            break;
+        }
+        case "orr"_pk: { // ORR instruction
+            if (args.size() < 3) throw invalid_argument("Too few arguments.");
+            orr(o, regst(args[1]), regst(args[2]), regst(args[0]), s, c);
+            break;
+        }
+        case "eor"_pk: { // EOR instruction
+            if (args.size() < 3) throw invalid_argument("Too few arguments.");
+            eor(o, regst(args[1]), regst(args[2]), regst(args[0]), s, c);
+            break;
+        }
+        case "lsl"_pk: { // LSL instruction
+            if (args.size() < 3) throw invalid_argument("Too few arguments.");
+            lsl(o, regst(args[1]), regst(args[2]), regst(args[0]), s, c);
+            break;
+        }
+        case "lsr"_pk: { // LSR instruction
+            if (args.size() < 3) throw invalid_argument("Too few arguments.");
+            lsr(o, regst(args[1]), regst(args[2]), regst(args[0]), s, c);
+            break;
+        }
+        case "asr"_pk: { // ASR instruction
+            if (args.size() < 3) throw invalid_argument("Too few arguments.");
+            asr(o, regst(args[1]), regst(args[2]), regst(args[0]), s, c);
+            break;
+        }
+        case "mli"_pk: { // MLI instruction
+            if (args.size() < 3) throw invalid_argument("Too few arguments.");
+            mli(o, regst(args[1]), immval(args[2].starts_with('#') ? args[2].substr(1) : args[2], d_lbl), regst(args[0]), c);
+            break;
+        }
+        case "prt"_pk: { // PRT instruction
+            if (args.size() < 1) throw invalid_argument("Too few arguments.");
+            prt(o, regst(args[0]), c);
+            break;
+        }
+        case "cmp"_pk: { // CMP instruction
+            if (args.size() < 2) throw invalid_argument("Too few arguments.");
+            cmp(o, regst(args[0]), regst(args[1]), c);
+            break;
+        }
+        case "jmp"_pk: { // JMP instruction
+            if (args.size() < 1) throw invalid_argument("Too few arguments.");
+            uint16_t addr = mem_iprg;
+            if (unknown(args[0], p_lbl)) fix.pb({ o.size(), fixlbl(args[0]), fix_ljr, PC, c, 0 }); // Forward label
+            else addr = immval(args[0], p_lbl);
+            addr -= mem_iprg; // 'addr' is an offset inside code segment
+            try {
+                jmp(o, addr, c);
+            } catch (out_of_range &e) {
+                throw e;
+            }
+            break;
+        }
+        case "psh"_pk: { // PSH instruction
+            bool multi;
+            vector<reg> rs = reglist(args, multi);
+            try {
+                if (multi) pshm(o, rs, c);
+                else psh(o, rs[0], c);
+            } catch (invalid_argument &e) {
+                throw e;
+            }
+            break;
+        }
+        case "pop"_pk: { // POP instruction
+            bool multi;
+            vector<reg> rs = reglist(args, multi);
+            try {
+                if (multi) popm(o, rs, c);
+                else pop(o, rs[0], c);
+            } catch (invalid_argument &e) {
+                throw e;
+            }
+            break;
+        }
+        case "cal"_pk: { // CAL instruction
+            if (args.size() < 1) throw invalid_argument("Too few arguments.");
+            uint16_t addr = mem_iprg;
+            if (unknown(args[0], p_lbl)) fix.pb({ o.size() + 4, fixlbl(args[0]), fix_ljr, PC, c, 0 }); // Forward label
+            else addr = immval(args[0], p_lbl);
+            addr -= mem_iprg; // 'addr' is an offset inside code segment
+            try {
+                cal(o, addr, c);
+            } catch (invalid_argument &e) {
+                throw e;
+            }
+            break;
+        }
+        case "ret"_pk: { // RET instruction
+            ret(o, c);
+            break;
+        }
+        case "nop"_pk: { // NOP instruction
+            nop(o, c);
+            break;
+        }
+        case "hlt"_pk: { // HLT instruction
+            hlt(o, c);
+            break;
+        }
+    }
+}
+
+// Assembled module: code and data of a single source file, with its labels and unresolved references.
+// Label addresses are those the module would have if it were the only one in the program.
+struct object {
+    string src; // Source filename
+    vector<uint16_t> dat; // Data section
+    vector<uint16_t> code; // Code
+    vector<bool> pin; // Microops which must survive optimization
+    vector<int> line; // Source line of every microop
+    vector<int> dline; // Source line of every data word
+    unordered_map<string,uint16_t> d_lbl; // Labels addresses (in .data section)
+    unordered_map<string,uint16_t> p_lbl; // Labels addresses (in .prgm section)
+    vector<fixup> fix; // Unresolved label references (relocations)
+    int errors = 0; // Number of errors reported
+};
+
+// Assembled program.
+struct program {
+    vector<uint16_t> dat; // Data section, from 'mem_idat' onwards
+    vector<uint16_t> code; // Code segment, from 'mem_iprg' onwards
+    vector<string> srcs; // Source filenames, by module
+    vector<pair<uint16_t,int>> line; // Module and source line of every microop
+    vector<pair<uint16_t,int>> dline; // Module and source line of every data word
+    vector<pair<string,uint16_t>> lbl; // Code labels addresses, by module
+    int errors = 0; // Number of errors reported
+};
+
+// Line of a source file: its number and its text (trimmed and lowercased).
+typedef pair<int,string> srcline;
+
+// Lines of a module, decoded for the optimizations which rewrite them.
+struct modcode {
+    size_t n; // Number of lines
+    vector<int> sec; // Section of every line: 0 -> none, 1 -> data, 2 -> prgm
+    vector<command> cmd; // Command of every line
+    vector<bool> ok; // Line is a valid instruction
+    unordered_map<string,size_t> lbl; // Code labels, by line
+    vector<bool> entry; // Line is the label of a function (a CAL target)
+    vector<size_t> fn; // Function of every line, up to the next one (n: none)
+
+    modcode(const vector<srcline> &in) : n(in.size()), sec(n), cmd(n), ok(n, false), entry(n, false), fn(n, n) {
+        for (size_t i = 0, cur = 0; i < n; ++i) {
+            const string &l = in[i].second;
+            if (l.compare(".data") == 0) cur = 1;
+            else if (l.compare(".prgm") == 0) cur = 2;
+            sec[i] = (l[0] == '.') ? 0 : cur;
+            if (sec[i] != 2) continue;
+            if (l[0] == '&') { lbl[l.substr(1)] = i; continue; }
+            try { cmd[i] = parseCmd(l); ok[i] = true; } catch (invalid_argument &e) {}
+        }
+        for (size_t i = 0; i < n; ++i) if (target(i) != "") entry[lbl[target(i)]] = true;
+        for (size_t i = 0, f = n; i < n; ++i) {
+            if (sec[i] != 2) f = n;
+            else if (entry[i]) f = i;
+            fn[i] = f;
+        }
+    }
+    // Argument without the braces of a register list.
+    static string_view bare(const string_view a) { return trim(a.substr(a.starts_with('{'), a.length() - a.starts_with('{') - a.ends_with('}'))); }
+    // Function called by a line ("" if none).
+    string target(const size_t i) const {
+        if (!ok[i] || cmd[i].m != "cal"_pk || cmd[i].args.size() < 1 || !cmd[i].args[0].starts_with('$')) return "";
+        string t(cmd[i].args[0].substr(1));
+        return lbl.count(t) ? t : "";
+    }
+    // Line of the label a jump goes to (n if not a jump to a label of the module).
+    size_t jumpTo(const size_t i) const {
+        if (!ok[i] || cmd[i].m != "jmp"_pk || cmd[i].args.size() < 1 || !cmd[i].args[0].starts_with('$')) return n;
+        auto it = lbl.find(string(cmd[i].args[0].substr(1)));
+        return (it != lbl.end()) ? it->second : n;
+    }
+};
+
+// Maximum size (in microops) of the body of a function inlined at its call sites
+#define inl_max     16
+
+// Optimize calls and returns in the code of a module, rewriting its lines.
+// Functions are the labels of the module which are CAL targets, and span up to the next one. Then:
+// - a CAL of a leaf function whose body is straight-line code up to 'inl_max' microops, ending with its only RET, is
+//   replaced by that body (saving the 7 microops of CAL and RET);
+// - a CAL immediately followed by a RET is a tail call, and becomes a JMP (so that the callee returns to our caller);
+// - functions with CALs left push LR on entry and pop it before every RET (and tail call), unless they use LR
+//   themselves: nested calls need no manual LR saving, while leaf functions do not pay for it. Jumps of a function back
+//   to its own label are moved past the push, to a label of their own ('<function>.lr').
+// @param in        Lines of the module (without empty lines and comments).
+// @return          Rewritten lines.
+inline vector<srcline> callopt(const vector<srcline> &in) {
+    modcode mc(in);
+    const size_t n = mc.n;
+    const vector<command> &cmd = mc.cmd;
+    const vector<bool> &ok = mc.ok, &entry = mc.entry;
+    const vector<size_t> &fn = mc.fn;
+    auto &lbl = mc.lbl;
+    auto bare = modcode::bare;
+    auto target = [&](const size_t i) { return mc.target(i); };
+    // Bodies of the functions which can be inlined
+    unordered_map<size_t,vector<srcline>> body;
+    for (size_t f = 0; f < n; ++f) {
+        if (!entry[f]) continue;
+        vector<srcline> b;
+        vector<uint16_t> o;
+        vector<fixup> fix;
+        unordered_map<string,uint16_t> none;
+        size_t i = f + 1;
+        bool inl = true;
+        for (; inl && i < n && fn[i] == f; ++i) {
+            if (!ok[i] || in[i].second[0] == '&') { inl = false; break; }
+            if (cmd[i].m == "ret"_pk) break;
+            if (cmd[i].m == "cal"_pk || cmd[i].m == "jmp"_pk) inl = false;
+            for (string_view a : cmd[i].args) if (bare(a) == "lr" || bare(a) == "r6" || bare(a) == "pc" || bare(a) == "r7") inl = false;
+            try { parseLine(in[i].second, none, none, regvals(), o, fix); } catch (exception &e) { inl = false; }
+            b.pb(in[i]);
+        }
+        if (inl && i < n && fn[i] == f && ok[i] && cmd[i].m == "ret"_pk && cmd[i].c == AL && o.size() <= inl_max) body[f] = b;
+    }
+    // Action at every CAL: 0 -> none, 1 -> inline, 2 -> tail call
+    vector<int> act(n, 0);
+    vector<bool> save(n, false), uselr(n, false); // Function needs to save LR, function uses LR
+    for (size_t i = 0; i < n; ++i) {
+        if (fn[i] == n || !ok[i]) continue;
+        for (string_view a : cmd[i].args) if (bare(a) == "lr" || bare(a) == "r6") uselr[fn[i]] = true;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        string t = target(i);
+        if (t == "") continue;
+        size_t f = lbl[t];
+        if (cmd[i].c == AL && body.count(f) && fn[i] != f) act[i] = 1;
+        else if (i + 1 < n && ok[i+1] && fn[i+1] == fn[i] && cmd[i+1].m == "ret"_pk && cmd[i+1].c == AL) act[i] = 2;
+        else if (fn[i] != n) save[fn[i]] = true;
+    }
+    // Labels past the push of LR, for the functions which jump back to their own label
+    unordered_map<size_t,string> loop;
+    for (size_t i = 0; i < n; ++i) {
+        if (fn[i] == n || mc.jumpTo(i) != fn[i] || !save[fn[i]] || uselr[fn[i]] || loop.count(fn[i])) continue;
+        string name = in[fn[i]].second.substr(1) + ".lr";
+        while (lbl.count(name)) name += "_";
+        loop[fn[i]] = name;
+    }
+    // Rewrite
+    vector<srcline> out;
+    for (size_t i = 0; i < n; ++i) {
+        const int c = in[i].first;
+        const string &l = in[i].second;
+        bool sv = fn[i] != n && save[fn[i]] && !uselr[fn[i]];
+        string cnd((ok[i] && l[0] != '&') ? trim(split(l, ':')[0]).substr(3) : ""); // Conditional suffix
+        if (fn[i] != n && mc.jumpTo(i) == fn[i] && loop.count(fn[i])) {
+            out.pb({ c, string(trim(split(l, ':')[0])) + ": $" + loop[fn[i]] });
+        } else if (act[i] == 1) {
+            for (const srcline &b : body[lbl[target(i)]]) out.pb({ c, b.second });
+        } else if (act[i] == 2) {
+            if (sv) out.pb({ c, "pop" + cnd + ": lr" });
+            out.pb({ c, "jmp" + l.substr(3) });
+            if (cmd[i].c == AL) ++i; // The RET is not reached anymore
+        } else if (sv && ok[i] && cmd[i].m == "ret"_pk) {
+            out.pb({ c, "pop" + cnd + ": lr" });
+            out.pb(in[i]);
+        } else {
+            out.pb(in[i]);
+            if (entry[i] && save[i] && !uselr[i]) out.pb({ c, "psh: lr" });
+            if (loop.count(i)) out.pb({ c, "&" + loop[i] });
+        }
+    }
+    return out;
+}
+
+// Drop the saves of registers nobody needs, and merge runs of PSH and POP into register lists, rewriting the lines of a
+// module.
+// Liveness of R0..R4 is computed backwards over the control flow of the module (CALs, RETs and jumps out of it read
+// every register). A function which pushes some registers on entry, and pops them back right before its RETs, need not
+// save those which are dead after all of its CALs, as long as it is entered by CALs alone and left by RETs alone.
+// @param in        Lines of the module (without empty lines and comments).
+// @param drop      Drop saves (only if no other module can call the functions).
+// @return          Rewritten lines.
+inline vector<srcline> saveopt(const vector<srcline> &in, const bool &drop) {
+    modcode mc(in);
+    const size_t n = mc.n;
+    const vector<command> &cmd = mc.cmd;
+    auto al = [&](const size_t i, const uint32_t m) { return mc.ok[i] && cmd[i].m == m && cmd[i].c == AL; };
+    auto regs = [&](const size_t i) { // Registers of a PSH or POP (in push order)
+        bool multi;
+        try { return reglist(cmd[i].args, multi); } catch (invalid_argument &e) { return vector<reg>(); }
+    };
+    auto bit = [](const string_view a) -> uint8_t { // Mask of a register among R0..R4
+        try { reg r = regst(modcode::bare(a)); return (r <= R4) ? 1 << r : 0; } catch (invalid_argument &e) { return 0; }
+    };
+    // Liveness
+    vector<uint8_t> use(n, 0), def(n, 0), in_l(n, 0), out_l(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        if (mc.sec[i] != 2 || in[i].second[0] == '&') continue;
+        if (!mc.ok[i]) { use[i] = 0x1f; continue; }
+        const vector<string_view> &args = cmd[i].args;
+        uint8_t d = 0;
+        switch (cmd[i].m) {
+            case "put"_pk: case "set"_pk: if (args.size() > 0) d = bit(args[0]); break;
+            case "mov"_pk: case "ldr"_pk: if (args.size() > 1) { d = bit(args[0]); use[i] = bit(args[1]); } break;
+            case "str"_pk: case "cmp"_pk: case "prt"_pk: for (string_view a : args) use[i] |= bit(a); break;
+            case "psh"_pk: for (string_view a : args) use[i] |= bit(a); break;
+            case "pop"_pk: for (string_view a : args) d |= bit(a); break;
+            case "jmp"_pk: case "nop"_pk: case "hlt"_pk: break;
+            case "cal"_pk: case "ret"_pk: use[i] = 0x1f; break;
+            default: // ALU operations
+                if (args.size() > 0) d = bit(args[0]);
+                for (size_t j = 1; j < args.size(); ++j) use[i] |= bit(args[j]);
+        }
+        if (cmd[i].c == AL) def[i] = d;
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = n; i-- > 0;) {
+            if (mc.sec[i] != 2) continue;
+            uint8_t o = 0;
+            bool jmp = mc.ok[i] && cmd[i].m == "jmp"_pk;
+            if (jmp) o |= (mc.jumpTo(i) < n) ? in_l[mc.jumpTo(i)] : 0x1f;
+            if (!(al(i, "jmp"_pk) || al(i, "ret"_pk) || al(i, "hlt"_pk))) o |= (i + 1 < n && mc.sec[i+1] == 2) ? in_l[i+1] : 0x1f;
+            uint8_t l = use[i] | (o & ~def[i]);
+            if (o != out_l[i] || l != in_l[i]) { out_l[i] = o; in_l[i] = l; changed = true; }
+        }
+    }
+    // Saves to drop, by line
+    vector<uint8_t> rm(n, 0);
+    vector<bool> entered(n, false); // Label is jumped to from outside its function
+    for (size_t i = 0; i < n; ++i) if (mc.jumpTo(i) < n && (mc.fn[mc.jumpTo(i)] != mc.fn[i] || mc.entry[mc.jumpTo(i)])) entered[mc.jumpTo(i)] = true;
+    for (size_t f = 0; drop && f < n; ++f) {
+        if (!mc.entry[f] || entered[f]) continue;
+        uint8_t saved = 0, dead = 0x1f;
+        vector<reg> pro; // Pushed on entry
+        size_t i = f + 1;
+        for (; i < n && al(i, "psh"_pk); ++i) for (reg r : regs(i)) pro.pb(r);
+        for (reg r : pro) saved |= (r <= R4) ? 1 << r : 0;
+        bool ok = saved != 0;
+        size_t last = f;
+        for (size_t j = f + 1; ok && j < n && mc.fn[j] == f; ++j) {
+            last = j;
+            if (entered[j] || (mc.jumpTo(j) == n && mc.ok[j] && cmd[j].m == "jmp"_pk)) ok = false; // Entered or left by a jump
+            if (mc.ok[j]) for (string_view a : cmd[j].args) if (modcode::bare(a) == "sp" || modcode::bare(a) == "r5" || modcode::bare(a) == "pc" || modcode::bare(a) == "r7") ok = false;
+            if (!mc.ok[j] || cmd[j].m != "ret"_pk) continue;
+            if (cmd[j].c != AL) { ok = false; break; }
+            vector<reg> epi; // Popped before the RET, in pop order
+            for (size_t k = j; k-- > f + 1 && al(k, "pop"_pk);) { vector<reg> rs = regs(k); epi.insert(epi.begin(), rs.rbegin(), rs.rend()); }
+            ok = ok && vector<reg>(epi.rbegin(), epi.rend()) == pro;
+        }
+        if (!ok || !(al(last, "ret"_pk) || al(last, "jmp"_pk) || al(last, "hlt"_pk))) continue;
+        for (size_t j = 0; j < n; ++j) if (mc.target(j) == in[f].second.substr(1)) dead &= ~out_l[j];
+        for (size_t j = 0; j < n; ++j) if (mc.ok[j]) for (string_view a : cmd[j].args) if (a.starts_with('$') && a.substr(1) == in[f].second.substr(1) && cmd[j].m != "cal"_pk) dead = 0; // Address taken
+        dead &= saved;
+        if (!dead) continue;
+        for (size_t j = f + 1; j < i; ++j) rm[j] = dead;
+        for (size_t j = f + 1; j < n && mc.fn[j] == f; ++j) if (al(j, "ret"_pk)) for (size_t k = j; k-- > f + 1 && al(k, "pop"_pk);) rm[k] = dead;
+    }
+    // Rewrite, merging runs of PSH and POP
+    auto list = [](const vector<reg> &rs) {
+        string l = "";
+        for (reg r : rs) l += (l.empty() ? "" : ", ") + string("r") + to_string((int)r);
+        return (rs.size() > 1) ? "{" + l + "}" : l;
+    };
+    vector<srcline> out;
+    for (size_t i = 0; i < n; ++i) {
+        bool psh = al(i, "psh"_pk), pop = al(i, "pop"_pk);
+        if (!(psh || pop) || regs(i).empty()) { out.pb(in[i]); continue; }
+        vector<reg> rs;
+        size_t j = i;
+        for (; j < n && al(j, cmd[i].m) && !regs(j).empty(); ++j) {
+            vector<reg> r = regs(j);
+            if (pop) reverse(r.begin(), r.end()); // Pop order
+            for (reg x : r) if (!(x <= R4 && (rm[j] >> x) & 1)) rs.pb(x);
+        }
+        bool merge = true;
+        for (reg x : rs) merge = merge && x != SP && x != PC;
+        if (!merge) { for (size_t k = i; k < j; ++k) out.pb(in[k]); i = j - 1; continue; }
+        if (pop) reverse(rs.begin(), rs.end());
+        if (!rs.empty()) out.pb({ in[i].first, (psh ? "psh: " : "pop: ") + list(rs) });
+        i = j - 1;
+    }
+    return out;
+}
+
+// Replace short forward branches by predicated code, rewriting the lines of a module:
+//   jmp<c>: $l                         jmp<c>: $l
+//   <then>                             <then>
+//   jmp: $m                          &l
+// &l
+//   <else>
+// &m
+// become '<then>' under the opposite of 'c' (and '<else>' under 'c'), provided that the bodies are made of unconditional
+// instructions which do not set flags nor call, and that '&l' is not used elsewhere. Since every microop takes a cycle
+// whether its condition holds or not, a branch is only replaced when predicated code costs no more microops than it,
+// on average over both paths. Conditions without an opposite (LE and GE) are left alone.
+// @param in        Lines of the module (without empty lines and comments).
+// @return          Rewritten lines.
+inline vector<srcline> ifconv(const vector<srcline> &in) {
+    const char *const names[] = { "", "eq", "ne", "lt", "le", "gt", "ge", "vs", "vc", "cs", "cc" };
+    modcode mc(in);
+    const size_t n = mc.n;
+    const vector<command> &cmd = mc.cmd;
+    unordered_map<string,int> refs; // References to every label
+    for (size_t i = 0; i < n; ++i) if (mc.ok[i]) for (string_view a : cmd[i].args) if (a.starts_with('$')) ++refs[string(a.substr(1))];
+    auto label = [&](const size_t i) { return (i < n && mc.sec[i] == 2 && in[i].second[0] == '&') ? in[i].second.substr(1) : string("#"); };
+    auto opposite = [](const cond c) { // Opposite condition (AL if none)
+        for (uint8_t o = EQ; o <= CC; ++o) if (condmask(o) == (uint16_t)~condmask(c)) return (cond)o;
+        return AL;
+    };
+    // Body from a line on: unconditional instructions, without flags, calls, jumps, labels (returns its end)
+    auto body = [&](size_t i) {
+        for (; i < n && mc.sec[i] == 2 && mc.ok[i] && cmd[i].c == AL && !cmd[i].s && cmd[i].m != "cmp"_pk && cmd[i].m != "cal"_pk && cmd[i].m != "jmp"_pk; ++i);
+        return i;
+    };
+    // Microops of lines under a condition
+    auto cost = [&](const size_t b, const size_t e, const cond c, vector<srcline> *out) {
+        vector<uint16_t> o;
+        vector<fixup> fix;
+        unordered_map<string,uint16_t> none;
+        for (size_t i = b; i < e; ++i) {
+            string l = in[i].second.substr(0, 3) + names[c] + in[i].second.substr(3);
+            try { parseLine(l, none, none, regvals(), o, fix); } catch (exception &e) { return SIZE_MAX / 4; }
+            if (out) out->pb({ in[i].first, l });
+        }
+        return o.size();
+    };
+    vector<srcline> out;
+    for (size_t i = 0; i < n; ++i) {
+        out.pb(in[i]);
+        if (mc.sec[i] != 2 || !mc.ok[i] || cmd[i].m != "jmp"_pk || cmd[i].c == AL || cmd[i].args.size() != 1 || !cmd[i].args[0].starts_with('$')) continue;
+        cond c = cmd[i].c, nc = opposite(c);
+        string l(cmd[i].args[0].substr(1));
+        if (nc == AL || refs[l] != 1) continue;
+        size_t t = body(i + 1); // End of <then>
+        if (t < n && mc.ok[t] && cmd[t].m == "jmp"_pk && cmd[t].c == AL && label(t + 1) == l) { // Diamond
+            size_t e = body(t + 2);
+            string m(cmd[t].args.size() == 1 ? cmd[t].args[0].substr(1) : "");
+            if (label(e) != m || m == "") continue;
+            // Paths: 'jmp<c>', <then>, 'jmp' (2 + then + 2) or 'jmp<c>', <else> (2 + else)
+            if (2 * (cost(i + 1, t, nc, nullptr) + cost(t + 2, e, c, nullptr)) > 6 + cost(i + 1, t, AL, nullptr) + cost(t + 2, e, AL, nullptr)) continue;
+            out.pop_back();
+            cost(i + 1, t, nc, &out);
+            cost(t + 2, e, c, &out);
+            i = e - 1;
+        } else if (label(t) == l) { // Triangle
+            // Paths: 'jmp<c>' (2) or 'jmp<c>', <then> (2 + then)
+            if (2 * cost(i + 1, t, nc, nullptr) > 4 + cost(i + 1, t, AL, nullptr)) continue;
+            out.pop_back();
+            cost(i + 1, t, nc, &out);
+            i = t - 1;
+        }
+    }
+    return out;
+}
+
+// Macro of a source.
+struct macro {
+    vector<string> params; // Parameter names (lowercase)
+    vector<token> body; // Lines
+};
+
+// Expander of the directives of a source (see 'preprocess').
+template <class reporter>
+struct preproc {
+    deque<string> &text; // Lines built by the expansion
+    const reporter &report;
+    vector<token> out; // Expanded tokens
+    unordered_map<string,int64_t> equ; // Constants (by lowercase name)
+    unordered_map<string,macro> mac; // Macros (by lowercase name)
+    int sec = 0; // Program section: 0 -> none, 1 -> data, 2 -> prgm
+    int uses = 0; // Macro expansions so far (for '\@')
+
+    preproc(deque<string> &text, const reporter &report) : text(text), report(report) {}
+
+    // Check whether a character may be part of a name.
+    static bool word(const char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+    // Check whether a name is valid for a macro or a parameter.
+    static bool ident(const string_view n) { return !n.empty() && !(n[0] >= '0' && n[0] <= '9') && all_of(n.begin(), n.end(), word); }
+    // Check whether a name is valid for a constant: it must not be a register, too.
+    static bool cname(const string_view n) {
+        if (!ident(n)) return false;
+        try { regst(n); return false; } catch (invalid_argument &e) { return true; }
+    }
+    // Replace every '\<name>' in a line by its value.
+    static string subst(const string_view l, const unordered_map<string,string> &val) {
+        string s;
+        for (size_t i = 0; i < l.length(); ++i) {
+            size_t n = 0; // Length of the name following a '\'
+            if (l[i] == '\\' && i + 1 < l.length() && l[i+1] == '@') n = 1;
+            else if (l[i] == '\\') while (i + 1 + n < l.length() && word(l[i+1+n])) ++n;
+            auto it = (n > 0) ? val.find(lc(l.substr(i + 1, n))) : val.end();
+            if (it != val.end()) { s += it->second; i += n; }
+            else s += l[i];
+        }
+        return s;
+    }
+    // Value of a constant expression: constants are replaced by their values, and labels are not allowed.
+    int64_t value(const string_view e) {
+        return eval(fold(e), [](const string_view) -> int64_t { throw invalid_argument("Constants cannot refer to labels."); });
+    }
+    // Replace the constants in an operand by their values.
+    string fold(const string_view e) {
+        string s;
+        for (size_t i = 0; i < e.length();) {
+            size_t n = 0;
+            if (e[i] == '$') n = 1 + lbllen(e.substr(i + 1));
+            else while (i + n < e.length() && word(e[i+n])) ++n;
+            if (n == 0) { s += e[i++]; continue; }
+            auto it = (e[i] >= '0' && e[i] <= '9') || e[i] == '$' ? equ.end() : equ.find(lc(e.substr(i, n)));
+            if (it == equ.end()) s += e.substr(i, n);
+            else s += (it->second < 0) ? "(" + to_string(it->second) + ")" : to_string(it->second);
+            i += n;
+        }
+        return s;
+    }
+    // Emit a line of code, with its operands folded: constants are replaced by their values, and expressions which do
+    // not refer to labels by theirs.
+    void emit(const token &t) {
+        const string_view l = t.s;
+        size_t at = string_view::npos; // Start of the operands
+        if (l[0] == '&') at = l.find('=');
+        else at = (sec == 1) ? 0 : l.find(':');
+        if (at == string_view::npos || (equ.empty() && l.find_first_of(exp_ops, at) == string_view::npos)) { out.pb(t); return; }
+        if (at > 0) ++at;
+        string s(l.substr(0, at));
+        vector<string_view> ops = split(l.substr(at), ',');
+        bool changed = false;
         try {
-            os << cal(addr, c);
+            for (size_t i = 0; i < ops.size(); ++i) {
+                string_view op = trim(ops[i]);
+                size_t h = op.starts_with('#'); // Immediates may be marked by '#'
+                string v = fold(op.substr(h));
+                if (v.find('$') == string::npos && isexpr(v)) v = to_string(value(v));
+                changed |= v != op.substr(h);
+                s += (i > 0) ? ", " : (at > 0) ? " " : "";
+                s += op.substr(0, h);
+                s += v;
+            }
         } catch (invalid_argument &e) {
-            throw e;
-        }
-    } else if (instr.compare("ret") == 0) { // RET instruction
-        os << ret(c);
-    } else if (instr.compare("nop") == 0) { // NOP instruction
-        os << nop(c);
-    } else if (instr.compare("hlt") == 0) { // HLT instruction
-        os << hlt(c);
-    } else {
-        throw invalid_argument("Unknown instruction.");
-    }
-    return os.str();
+            report(t.line, e.what());
+            return;
+        }
+        if (!changed) { out.pb(t); return; }
+        text.pb(s);
+        out.pb({ text.back(), t.line, t.col });
+    }
+    // Index of the line closing a block.
+    // @param ls        Lines.
+    // @param i         Index of the line opening the block.
+    // @param e         End of the lines to search.
+    // @param open      Directive opening blocks of the same kind.
+    // @param close     Directive closing them.
+    // @return          Index of the closing line ('e' if there is none).
+    static size_t closing(const vector<token> &ls, size_t i, const size_t e, const string_view open, const string_view close) {
+        for (int depth = 1; ++i < e;) {
+            string_view d = ls[i].s.substr(0, ls[i].s.find(' '));
+            if (ieq(d, open)) ++depth;
+            else if (ieq(d, close) && --depth == 0) break;
+        }
+        return i;
+    }
+    // Expand lines.
+    // @param ls        Lines.
+    // @param b         Index of the first line.
+    // @param e         Index past the last line.
+    // @param depth     Nesting of macros and repetitions.
+    // @param use       Line of the use of the macro being expanded (0 if none): expanded lines take its number.
+    void run(const vector<token> &ls, const size_t b, const size_t e, const int depth, const int use) {
+        if (depth > 64) { report(use, "Macros nested too deeply."); return; }
+        for (size_t i = b; i < e; ++i) {
+            token t = ls[i];
+            if (use > 0) t.line = use;
+            const string_view l = t.s;
+            if (l[0] == '.') {
+                size_t sp = min(l.find(' '), l.length());
+                string d = lc(l.substr(0, sp));
+                string_view rest = trim(l.substr(sp));
+                try {
+                    if (d == ".equ") { // Constant
+                        size_t comma = min(rest.find(','), rest.length());
+                        string_view n = trim(rest.substr(0, comma));
+                        if (!cname(n)) throw invalid_argument("Invalid constant name '" + string(n) + "'.");
+                        if (comma == rest.length()) throw invalid_argument("Too few arguments.");
+                        equ[lc(n)] = value(trim(rest.substr(comma + 1)));
+                    } else if (d == ".macro") { // Macro definition
+                        size_t j = closing(ls, i, e, ".macro", ".endm");
+                        swap(i, j); // Carry on past the definition, even if it is not valid
+                        if (i == e) throw invalid_argument("Missing '.endm'.");
+                        size_t colon = min(rest.find(':'), rest.length());
+                        string_view n = trim(rest.substr(0, colon));
+                        if (!ident(n)) throw invalid_argument("Invalid macro name '" + string(n) + "'.");
+                        macro m;
+                        if (colon < rest.length()) for (string_view p : split(rest.substr(colon + 1), ',')) {
+                            if (!ident(trim(p))) throw invalid_argument("Invalid parameter name '" + string(trim(p)) + "'.");
+                            m.params.pb(lc(trim(p)));
+                        }
+                        m.body.assign(ls.begin() + j + 1, ls.begin() + i);
+                        mac[lc(n)] = m;
+                    } else if (d == ".rept") { // Repetition
+                        size_t j = closing(ls, i, e, ".rept", ".endr");
+                        swap(i, j); // Carry on past the repeated lines, even if they cannot be repeated
+                        if (i == e) throw invalid_argument("Missing '.endr'.");
+                        vector<string_view> a = split(rest, ',');
+                        int64_t n = value(a.empty() ? "" : trim(a[0]));
+                        if (n < 0 || n > mem_end) throw out_of_range("Invalid repetition count " + to_string(n) + ".");
+                        if (a.size() > 2 || (a.size() == 2 && !ident(trim(a[1])))) throw invalid_argument("Invalid repetition counter.");
+                        for (int64_t k = 0; k < n; ++k) {
+                            if (a.size() < 2) { run(ls, j + 1, i, depth + 1, use); continue; }
+                            vector<token> body;
+                            for (size_t x = j + 1; x < i; ++x) {
+                                text.pb(subst(ls[x].s, { { lc(trim(a[1])), to_string(k) } }));
+                                body.pb({ text.back(), ls[x].line, ls[x].col });
+                            }
+                            run(body, 0, body.size(), depth + 1, use);
+                        }
+                    } else if (d == ".endm" || d == ".endr") throw invalid_argument("Unexpected '" + d + "'.");
+                    else { // Section, or an unknown directive (reported by the parser)
+                        if (ieq(l, ".data")) sec = 1;
+                        else if (ieq(l, ".prgm")) sec = 2;
+                        out.pb(t);
+                    }
+                } catch (logic_error &x) {
+                    report(t.line, x.what());
+                }
+                continue;
+            }
+            if (l[0] != '&' && sec == 2 && !mac.empty()) { // Use of a macro
+                size_t colon = min(l.find(':'), l.length());
+                auto it = mac.find(lc(trim(l.substr(0, colon))));
+                if (it != mac.end()) {
+                    const macro &m = it->second;
+                    vector<string_view> args = (colon < l.length()) ? split(trim(l.substr(colon + 1)), ',') : vector<string_view>();
+                    if (args.size() != m.params.size()) { report(t.line, (args.size() < m.params.size()) ? "Too few arguments." : "Too many arguments."); continue; }
+                    unordered_map<string,string> val = { { "@", to_string(uses++) } };
+                    for (size_t k = 0; k < args.size(); ++k) val[m.params[k]] = string(trim(args[k]));
+                    vector<token> body;
+                    for (const token &x : m.body) {
+                        text.pb(subst(x.s, val));
+                        body.pb({ text.back(), x.line, x.col });
+                    }
+                    run(body, 0, body.size(), depth + 1, t.line);
+                    continue;
+                }
+            }
+            emit(t);
+        }
+    }
+};
+
+// Expand the directives of a source, leaving plain lines of code:
+//   .equ <name>, <expr>            defines a constant (which may be redefined later), used by its name in operands;
+//   .macro <name>[: <param>, ...]  defines a macro, up to the matching '.endm', used like an instruction
+//                                  ('<name>: <arg>, ...'); '\<param>' in its lines stands for an argument, and '\@' for a
+//                                  number unique to every use (for labels);
+//   .rept <count>[, <name>]        repeats (unrolls) the lines up to the matching '.endr', '\<name>' standing for the
+//                                  number of every repetition, from 0.
+// Operands are folded: constants are replaced by their values, and expressions which do not refer to labels by theirs,
+// so that everything is computed at assembly time. Lines of a macro take the line number of its use.
+// @param toks      Tokens of the source.
+// @param text      Lines built by the expansion, which tokens returned may point into.
+// @param report    Function reporting an error on a line (line number, message).
+// @return          Tokens of the expanded source.
+template <class reporter>
+inline vector<token> preprocess(const vector<token> &toks, deque<string> &text, const reporter &report) {
+    preproc<reporter> p(text, report);
+    p.out.reserve(toks.size());
+    p.run(toks, 0, toks.size(), 0, 0);
+    return p.out;
 }
 
-// Parse a text file and build the binary code.
-// @param src       Name of the source file.
-// @return          String containing the assembled code.
-string parsePrg(const string &src) {
-    oss bin;
-    // 1) Parse .data section & compute pointers addresses
-    ifs prg(src);
-    uint16_t ptr = 0x0000, eod = 0x0008;
+// Assemble a text file into a module, in a single pass.
+// The file is mapped into memory and lexed into views of its lines, which are parsed in place, ignoring case (text is
+// only copied for label names, and for the lines rewritten by the optimizations).
+// Code is emitted into a buffer; references to labels which are not known yet are recorded as fixups. PUTs of code
+// labels always go through a fixup, since the optimizer may move them. A relocatable module records every label
+// reference as a fixup, since its sections may be moved by the linker.
+// @param src       Name of the source.
+// @param text      Source text.
+// @param err       Stream errors are reported to.
+// @param reloc     Build a relocatable module. Default: false.
+// @param calls     Optimize calls and returns (see 'callopt'). Default: false.
+// @return          Assembled module.
+object assemble(const string &src, const string_view text, ostream &err, const bool &reloc = false, const bool &calls = false) {
+    object out;
+    out.src = src;
+    auto report = [&](const int line, const string &msg) {
+        err << "Error on line " << line << ": " << msg << nl;
+        ++out.errors;
+    };
+    vector<uint16_t> &code = out.code;
     int sec = 0; // Program section: 0 -> none, 1 -> data, 2 -> prgm
     int c = 0; // Line counter
-    unordered_map<string,uint16_t> d_lbl; // Labels addresses (in .data section)
-    unordered_map<string,uint16_t> p_lbl; // Labels addresses (in .prgm section)
-    string line;
-    while (getline(prg, line)) {
-        ++c;
-        line = lc(trim(line)); // Trim and lowercase
-        if (line.compare("") == 0 || line[0] == '#') continue; // Skip empty lines and comments
-        if (line.compare(".data") == 0) { sec = 1; ptr = mem_idat; continue; } // Start of data section
-        else if (line.compare(".prgm") == 0) { sec = 2; eod = ptr; ptr = mem_iprg; continue; } // Start of prgm section
+    unordered_map<string,uint16_t> none; // Labels visible to a relocatable module's code: none
+    unordered_map<string,uint16_t> &d_lbl = reloc ? none : out.d_lbl;
+    unordered_map<string,uint16_t> &p_lbl = reloc ? none : out.p_lbl;
+    regvals known; // Known register contents
+    deque<string> exp; // Lines built by the expansion of directives
+    vector<token> toks = preprocess(lex(text), exp, report);
+    vector<srcline> lines; // Lines rewritten by the optimizations (lowercased), which 'toks' then points into
+    if (calls) {
+        for (const token &t : toks) lines.pb({ t.line, lc(t.s) });
+        lines = ifconv(saveopt(callopt(lines), !reloc));
+        toks.clear();
+        for (const srcline &l : lines) toks.pb({ l.second, l.first, 1 });
+    }
+    for (const token &t : toks) {
+        c = t.line;
+        const string_view line = t.s;
+        if (ieq(line, ".data")) { sec = 1; continue; } // Start of data section
+        else if (ieq(line, ".prgm")) { sec = 2; continue; } // Start of prgm section
         if (sec == 1) { // Write data
-            vector<string> values;
+            vector<string_view> values;
             if (line[0] == '&') { // If there is a label on this line
-                vector<string> s = split(line, '=');
-                d_lbl[s[0].substr(1)] = ptr; // Store label address
-                values = split(trim(s[1]), ',');
+                vector<string_view> s = split(line, '=');
+                out.d_lbl[lc(s[0].substr(1))] = mem_idat + out.dat.size(); // Store label address
+                if (s.size() > 1) values = split(trim(s[1]), ',');
             } else values = split(line, ',');
-            for (string q : values) { // Values
-                bin << bin2hex(stoi(trim(q), nullptr, 10)) << " ";
-                ++ptr;
+            for (string_view q : values) { // Values
+                try {
+                    out.dat.pb(stoi(string(trim(q)), nullptr, 10));
+                    out.dline.pb(c);
+                } catch (logic_error &e) {
+                    report(c, "Invalid value '" + string(trim(q)) + "'.");
+                }
             }
         } else if (sec == 2) {
-            if (line[0] == '&') p_lbl[line.substr(1)] = ptr; // Store label address
+            if (line[0] == '&') { out.p_lbl[lc(line.substr(1))] = mem_iprg + code.size(); known.clear(); } // Store label address
             else {
+                size_t c0 = code.size(), f0 = out.fix.size();
                 try {
-                    ptr += nom(line, d_lbl);
+                    parseLine(line, d_lbl, p_lbl, known, code, out.fix); // Parse single line
+                    for (size_t i = f0; i < out.fix.size(); ++i) out.fix[i].line = c;
                 } catch (invalid_argument &e) {
-                    cerr << "Error on line " << c << ": " << e.what() << nl;
+                    code.resize(c0); out.fix.resize(f0);
+                    report(c, e.what());
+                } catch (out_of_range &e) {
+                    code.resize(c0); out.fix.resize(f0);
+                    report(c, e.what());
                 }
+                out.pin.resize(code.size(), pk(line.substr(0, 3)) == "cal"_pk); // Return address of CAL is computed from PC
+                out.line.resize(code.size(), c);
+                track(line, d_lbl, known);
             }
         }
     }
-    if (mem_iprg < eod) cerr << "Error: data section exceeds ~32KB and therefore program cannot be compiled." << nl;
-    bin << nl << (mem_iprg - eod) << "*0" << nl; // Fill remaining data section with 0s
-    prg.close();
-    // 2) Parse .prgm section
-    prg.open(src);
-    c = 0; sec = 0;
-    while (getline(prg, line)) {
-        ++c;
-        line = lc(trim(line));
-        if (line.compare("") == 0 || line[0] == '#') continue;
-        if (line.compare(".prgm") == 0) { sec = 2; continue; }
-        if (sec == 2) {
-            if (line[0] == '&') continue; // Skip labels, they've already been computed
-            else {
-                try {
-                    bin << parseLine(line, d_lbl, p_lbl); // Parse single line
-                } catch (invalid_argument &e) {
-                    cerr << "Error on line " << c << ": " << e.what() << nl;
-                } catch (out_of_range &e) {
-                    cerr << "Error on line " << c << ": " << e.what() << nl;
-                }
+    return out;
+}
+
+// Assemble a text file into a module (see above).
+// @param src       Name of the source file.
+// @param err       Stream errors are reported to.
+// @param reloc     Build a relocatable module. Default: false.
+// @param calls     Optimize calls and returns (see 'callopt'). Default: false.
+// @return          Assembled module.
+object assemble(const string &src, ostream &err, const bool &reloc = false, const bool &calls = false) {
+    srcfile prg(src);
+    return assemble(src, prg.text, err, reloc, calls);
+}
+
+// Link modules into a program: their data sections and code are laid out one after the other, in the given order (so
+// the program starts from the first module's code), and fixups are patched.
+// A label reference is resolved in the referencing module first, then in the only other module defining it.
+// @param objs      Modules (label addresses are moved to their place in the program).
+// @param err       Stream errors are reported to.
+// @param opt       Run the peephole optimizer over the code segment. Default: false.
+// @return          Linked program.
+program link(vector<object> &objs, ostream &err, const bool &opt = false) {
+    program out;
+    vector<uint16_t> &code = out.code;
+    vector<bool> pin;
+    unordered_map<string,vector<size_t>> defs; // Modules defining each label
+    for (size_t m = 0; m < objs.size(); ++m) {
+        object &o = objs[m];
+        out.errors += o.errors;
+        for (auto &l : o.d_lbl) { l.second += out.dat.size(); defs[l.first].pb(m); }
+        for (auto &l : o.p_lbl) { l.second += code.size(); if (o.d_lbl.find(l.first) == o.d_lbl.end()) defs[l.first].pb(m); }
+        for (fixup &f : o.fix) f.at += code.size();
+        out.dat.insert(out.dat.end(), o.dat.begin(), o.dat.end());
+        code.insert(code.end(), o.code.begin(), o.code.end());
+        pin.insert(pin.end(), o.pin.begin(), o.pin.end());
+        out.srcs.pb(o.src);
+        for (int l : o.line) out.line.pb({ m, l });
+        for (int l : o.dline) out.dline.pb({ m, l });
+    }
+    if (mem_idat + out.dat.size() > mem_iprg) {
+        err << "Error: data section exceeds ~32KB and therefore program cannot be compiled." << nl;
+        ++out.errors;
+    }
+    auto report = [&](const object &o, const int line, const string &msg) {
+        if (objs.size() > 1) err << o.src << ": ";
+        err << "Error on line " << line << ": " << msg << nl;
+        ++out.errors;
+    };
+    // Resolve a label: 0 -> not found, 1 -> data label, 2 -> code label
+    auto label = [&](const object &o, const string &lbl, const uint8_t kind, uint16_t &val) -> int {
+        const object *d = &o;
+        if (o.d_lbl.find(lbl) == o.d_lbl.end() && o.p_lbl.find(lbl) == o.p_lbl.end()) {
+            auto it = defs.find(lbl);
+            if (it == defs.end()) return 0;
+            if (it->second.size() > 1) throw invalid_argument("Ambiguous label.");
+            d = &objs[it->second[0]];
+        }
+        auto dl = d->d_lbl.find(lbl), pl = d->p_lbl.find(lbl);
+        if (kind == fix_put && dl != d->d_lbl.end()) { val = dl->second; return 1; }
+        if (pl == d->p_lbl.end()) return 0;
+        val = pl->second;
+        return 2;
+    };
+    // Code labels as they would be if microops were dropped: positions of the sequences shortened, and microops dropped
+    // up to each of them
+    vector<size_t> cut_at, cut_n;
+    auto moved = [&](const uint16_t addr) -> uint16_t {
+        size_t j = lower_bound(cut_at.begin(), cut_at.end(), (size_t)(addr - mem_iprg)) - cut_at.begin();
+        return (j > 0) ? addr - cut_n[j-1] : addr;
+    };
+    // Resolve the label, or expression of labels, of a fixup: 1 -> data labels only, 2 -> some code label
+    auto resolve = [&](const object &o, const fixup &f, uint16_t &val) -> int {
+        int kind = 1;
+        val = fixval(f.lbl, [&](const string_view l) -> int64_t {
+            uint16_t v = 0;
+            int k = label(o, string(l), f.kind, v);
+            if (k == 0) throw invalid_argument("Invalid label.");
+            if (k == 2) v = moved(v);
+            kind = max(kind, k);
+            return v;
+        });
+        return kind;
+    };
+    // Patch fixups
+    vector<uint16_t> seq;
+    auto patch = [&](const fixup &f, const uint16_t val, const size_t len = putlen) {
+        if (f.kind == fix_ljr) { code[f.at] = LJR(val - mem_iprg); return; }
+        seq.clear();
+        putfixed(seq, f.r, val, f.c, len);
+        copy(seq.begin(), seq.end(), code.begin() + f.at);
+    };
+    // Move labels, source lines and fixups after microops are dropped
+    auto relocate = [&](const vector<uint16_t> &remap) {
+        for (size_t j = 0; j + 1 < remap.size(); ++j) if (remap[j+1] != remap[j]) out.line[remap[j]] = out.line[j]; // Surviving microops
+        out.line.resize(code.size());
+        for (object &o : objs) for (auto &l : o.p_lbl) if (l.second >= mem_iprg && (size_t)(l.second - mem_iprg) < remap.size()) l.second = mem_iprg + remap[l.second - mem_iprg];
+        for (object &o : objs) for (fixup &f : o.fix) f.at = remap[f.at];
+    };
+    vector<int> kind; // Kind of label of every fixup
+    for (object &o : objs) for (fixup &f : o.fix) {
+        uint16_t val = 0;
+        kind.pb(0);
+        try {
+            kind.back() = resolve(o, f, val);
+            patch(f, val);
+        } catch (invalid_argument &e) {
+            report(o, f.line, e.what());
+        } catch (out_of_range &e) {
+            report(o, f.line, e.what());
+        }
+        if (kind.back() == 2 && f.kind == fix_put) fill(pin.begin() + f.at, pin.begin() + f.at + putlen, true); // Repatched after optimization
+    }
+    if (opt && out.errors == 0) {
+        vector<bool> lead(code.size(), false);
+        for (object &o : objs) for (auto &l : o.p_lbl) if (l.second >= mem_iprg && (size_t)(l.second - mem_iprg) < code.size()) lead[l.second - mem_iprg] = true;
+        for (uint16_t instr : code) { // Numeric jump targets
+            if ((instr & 0x8000) || !(instr & 0x1)) continue;
+            uint16_t t = (instr >> 1) & 0x3fff;
+            if (t < code.size()) lead[t] = true;
+        }
+        relocate(peephole(code, lead, pin));
+        // Shrink the PUTs of code labels to the length of their value. Shortening them moves the labels after them, and
+        // so the values: lengths are computed again on the moved labels until none grows (after the first round, they
+        // only grow, so that this ends)
+        vector<pair<const object*,fixup*>> lp; // PUTs of code labels, by position
+        size_t i = 0;
+        for (object &o : objs) for (fixup &f : o.fix) if (kind[i++] == 2 && f.kind == fix_put) lp.pb({ &o, &f });
+        sort(lp.begin(), lp.end(), [](const pair<const object*,fixup*> &a, const pair<const object*,fixup*> &b) { return a.second->at < b.second->at; });
+        vector<size_t> len(lp.size(), putlen);
+        for (bool first = true, changed = true; changed; first = false) {
+            changed = false;
+            vector<size_t> need(lp.size());
+            for (size_t j = 0; j < lp.size(); ++j) {
+                uint16_t val = 0;
+                resolve(*lp[j].first, *lp[j].second, val);
+                seq.clear();
+                put(seq, lp[j].second->r, val, lp[j].second->c);
+                need[j] = seq.size();
+            }
+            cut_at.clear(); cut_n.clear();
+            for (size_t j = 0; j < lp.size(); ++j) {
+                if (first || need[j] > len[j]) { changed |= need[j] != len[j]; len[j] = need[j]; }
+                cut_at.pb(lp[j].second->at);
+                cut_n.pb((j > 0 ? cut_n.back() : 0) + putlen - len[j]);
             }
         }
+        vector<bool> del(code.size(), false);
+        for (size_t j = 0; j < lp.size(); ++j) fill(del.begin() + lp[j].second->at + len[j], del.begin() + lp[j].second->at + putlen, true);
+        cut_at.clear(); cut_n.clear();
+        relocate(compact(code, del));
+        for (size_t j = 0; j < lp.size(); ++j) {
+            uint16_t val = 0;
+            resolve(*lp[j].first, *lp[j].second, val);
+            patch(*lp[j].second, val, len[j]);
+        }
+    }
+    for (object &o : objs) for (auto &l : o.p_lbl) out.lbl.pb(l);
+    sort(out.lbl.begin(), out.lbl.end(), [](const pair<string,uint16_t> &a, const pair<string,uint16_t> &b) { return a.second < b.second; });
+    return out;
+}
+
+// Append to a program the modules of the runtime library it needs: those defining labels which its modules reference
+// but do not define, and in turn those the library modules reference.
+// @param objs      Modules of the program (library modules are appended to them, relocatable).
+// @param err       Stream errors are reported to.
+inline void autolink(vector<object> &objs, ostream &err) {
+    for (size_t n = 0; n < objs.size(); ++n) { // Modules appended are scanned in turn
+        for (size_t i = 0; i < objs[n].fix.size(); ++i) {
+            const string lbl = objs[n].fix[i].lbl; // 'objs' may grow below
+            if (any_of(objs.begin(), objs.end(), [&](const object &o) { return o.p_lbl.count(lbl) || o.d_lbl.count(lbl); })) continue;
+            const rtmod *m = rtlabel(lbl);
+            if (m) objs.pb(assemble(string(m->name), m->src, err, true));
+        }
     }
-    prg.close();
-    return bin.str();
 }
 
-#endif
\ No newline at end of file
+// Parse a text file and build the binary code of a program made of it alone, and of the runtime library it needs.
+// @param src       Name of the source file.
+// @param err       Stream errors are reported to.
+// @param opt       Optimization level: 1 -> run the peephole optimizer over the code segment, 2 -> also optimize calls
+//                  and returns. Default: 0.
+// @return          Assembled program.
+program parsePrg(const string &src, ostream &err, const int &opt = 0) {
+    vector<object> objs = { assemble(src, err, false, opt >= 2) };
+    autolink(objs, err);
+    return link(objs, err, opt);
+}
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ * ===================
+ * RCC - RC16 COMPILER
+ * ===================
+ *
+ * PEEPHOLE OPTIMIZER
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef PEEP
+#define PEEP
+
+// Value numbers: constants are numbered by their value, jump targets and fresh values above
+#define vn_jr       0x10000 // Base of JR targets
+#define vn_fresh    0x20000 // First unknown value
+
+// Value numbering state over the register file.
+struct vnstate {
+    uint32_t r[16]; // Value number held by each register
+    uint32_t next = vn_fresh; // Next unknown value
+    unordered_map<uint64_t,uint32_t> exc; // Value numbers of ALU results, by (op-code, '~B', A, B)
+
+    // Forget the content of every register.
+    void reset() { for (uint32_t &v : r) v = next++; }
+    // Value number of the result of an ALU operation.
+    uint32_t alu(const uint8_t op, const bool notb) {
+        uint32_t a = r[A], b = (op == NOT) ? 0 : r[B];
+        if (a < vn_jr && b < vn_jr) { // Fold constants
+            uint8_t f;
+            return ::alu(a, b, op, notb, f);
+        }
+        uint64_t key = ((uint64_t)op << 60) | ((uint64_t)notb << 59) | ((uint64_t)a << 30) | b;
+        auto it = exc.find(key);
+        if (it != exc.end()) return it->second;
+        return exc[key] = next++;
+    }
+};
+
+// Drop microops from the code segment, moving the jump targets of the LJRs left to the new position of the microop
+// they pointed to.
+// @param code      Microops of the code segment, from 'mem_iprg' onwards (modified).
+// @param del       Per-microop flag: microop is dropped.
+// @return          New offset of every old offset inside the code segment (one entry past the end).
+inline vector<uint16_t> compact(vector<uint16_t> &code, const vector<bool> &del) {
+    size_t n = code.size();
+    vector<uint16_t> remap(n + 1);
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        remap[i] = k;
+        if (!del[i]) code[k++] = code[i];
+    }
+    remap[n] = k;
+    code.resize(k);
+    for (uint16_t &instr : code) {
+        if ((instr & 0x8000) || !(instr & 0x1)) continue;
+        uint16_t t = (instr >> 1) & 0x3fff;
+        t = (t <= n) ? remap[t] : t - (n - k); // Targets past the program keep their distance from its end
+        instr = 0x1 | (t << 1);
+    }
+    return remap;
+}
+
+// Remove redundant microops from the code segment.
+// A forward pass numbers the values held by registers and drops NOPs and the moves, SETs, LJRs and EXCs which would not
+// change them (pinned microops are kept and yield unknown values, since they may be patched after optimization);
+// a backward pass drops EXCs whose OUT is overwritten before being read. State is forgotten at jump targets and after
+// every write to PC. Jump targets of surviving LJRs are then moved to the new position of the microop they pointed to.
+// @param code      Microops of the code segment, from 'mem_iprg' onwards (modified).
+// @param lead      Per-microop flag: microop is the target of a label.
+// @param pin       Per-microop flag: microop must be kept (PC-relative or later patched sequences).
+// @return          New offset of every old offset inside the code segment (one entry past the end).
+inline vector<uint16_t> peephole(vector<uint16_t> &code, const vector<bool> &lead, const vector<bool> &pin) {
+    size_t n = code.size();
+    vector<bool> del(n, false);
+    // 1) Forward pass: redundant writes
+    vnstate s;
+    s.reset();
+    for (size_t i = 0; i < n; ++i) {
+        if (lead[i]) s.reset();
+        uint16_t instr = code[i];
+        bool al = ((instr >> 10) & 0xf) == AL, jump = false;
+        uint32_t v = 0;
+        int8_t dst = -1; // Destination register, if the microop writes one
+        if (!(instr & 0x8000) && (instr & 0x1)) { // LJR
+            v = vn_jr + ((instr >> 1) & 0x3fff);
+            dst = JR;
+            al = true;
+        } else switch (instr >> 14) {
+            case 0x0: // NOP, HLT
+                jump = instr & 0x200;
+                if (!jump && !pin[i]) del[i] = true;
+                break;
+            case 0x1:
+                if (!(instr & 0x200)) { // MOV (reg->reg)
+                    uint8_t src = (instr >> 5) & 0xf;
+                    dst = (instr >> 1) & 0xf;
+                    v = (src == PC) ? s.next++ : s.r[src];
+                } else if (!(instr & 0x100)) { // MOV (mem->reg)
+                    dst = (instr >> 4) & 0xf;
+                    v = s.next++;
+                }
+                break;
+            case 0x2: // SET
+                dst = (instr >> 6) & 0xf;
+                v = instr & 0x3f;
+                break;
+            case 0x3: // EXC
+                dst = OUT;
+                v = s.alu((instr >> 7) & 0x7, instr & 0x40);
+                if (instr & 0x20) { // Flags are an effect of their own
+                    s.r[OUT] = al ? v : s.next++;
+                    dst = -1;
+                }
+                break;
+        }
+        if (dst == PC) jump = true;
+        if (pin[i]) { // May be patched later: its effect is unknown
+            if (dst >= 0) s.r[dst] = s.next++;
+            if ((instr >> 14) == 0x3) s.r[OUT] = s.next++;
+        } else if (dst >= 0 && dst != PC && dst != OR) {
+            if (s.r[dst] == v) del[i] = true; // Same value as before, whether or not the condition holds
+            else s.r[dst] = al ? v : s.next++;
+        }
+        if (jump) s.reset();
+    }
+    // 2) Backward pass: dead OUT writes
+    bool live = true;
+    for (size_t i = n; i-- > 0;) {
+        if (del[i]) continue;
+        uint16_t instr = code[i];
+        if (i + 1 < n && lead[i+1]) live = true;
+        if (!(instr & 0x8000) && (instr & 0x1)) continue; // LJR
+        uint8_t kind = instr >> 14;
+        if (kind == 0x0 && (instr & 0x200)) live = true; // HLT
+        else if (kind == 0x1 && !(instr & 0x200)) { // MOV (reg->reg)
+            if (((instr >> 1) & 0xf) == PC) live = true;
+            if (((instr >> 5) & 0xf) == OUT) live = true;
+        } else if (kind == 0x1) { // MOV (reg<->mem)
+            if ((instr & 0x100) && ((instr >> 4) & 0xf) == OUT) live = true;
+            if (!(instr & 0x100) && ((instr >> 4) & 0xf) == PC) live = true;
+        } else if (kind == 0x2 && ((instr >> 6) & 0xf) == PC) live = true;
+        else if (kind == 0x3) {
+            if (!live && !(instr & 0x20) && !pin[i]) del[i] = true;
+            else if (((instr >> 10) & 0xf) == AL) live = false;
+        }
+    }
+    // 3) Compact and move jump targets
+    return compact(code, del);
+}
+
+#endif
@@ -0,0 +1,261 @@
+/**
+ * ===================
+ * RCE - RC16 EMULATOR
+ * ===================
+ *
+ * EXECUTION PROFILER
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef PROF
+#define PROF
+
+// Microop classes of the histogram
+#define cls_movreg      0x0 // MOV (reg->reg)
+#define cls_ldm         0x1 // MOV (mem->reg)
+#define cls_stm         0x2 // MOV (reg->mem)
+#define cls_set         0x3 // SET
+#define cls_exc         0x4 // EXC, plus ALU op-code (0x4 -> 0xb)
+#define cls_ljr         0xc // LJR
+#define cls_nop         0xd // NOP
+#define cls_hlt         0xe // HLT
+const char *const cls_names[] = { "MOVREG", "MOVMEM (read)", "MOVMEM (write)", "SET", "EXC ADD", "EXC AND", "EXC ORR", "EXC EOR",
+                                  "EXC NOT", "EXC LSL", "EXC LSR", "EXC ASR", "LJR", "NOP", "HLT" };
+
+// Symbols of a program, as written by rcc and rcl ('-g').
+struct symbols {
+    vector<string> srcs; // Source filenames, by module
+    vector<pair<uint16_t,string>> lbl; // Code labels, by address
+    vector<pair<uint16_t,int>> line = vector<pair<uint16_t,int>>(mem_end+1, { 0, 0 }); // Module and source line of every address (0: unknown)
+};
+
+// Read the symbols of a program.
+// @param file      Symbol filename.
+// @return          Symbols.
+inline symbols readSym(const string &file) {
+    ifs in(file);
+    if (!in) throw invalid_argument("Given symbol file does not exist or is unaccessible.");
+    string line;
+    if (!getline(in, line) || line.compare("rcs") != 0) throw invalid_argument("Not an RC16 symbol file.");
+    symbols s;
+    int c = 1; // Line counter
+    while (getline(in, line)) {
+        ++c;
+        iss ls(line);
+        string rec, name;
+        uint32_t addr, n, mod;
+        int ln;
+        ls >> rec;
+        bool ok = true;
+        if (rec.compare("src") == 0) {
+            ok = (ls >> mod >> ws) && getline(ls, name) && mod == s.srcs.size();
+            if (ok) s.srcs.pb(name);
+        } else if (rec.compare("lbl") == 0) {
+            ok = (ls >> hex >> addr >> ws) && getline(ls, name) && addr <= mem_end;
+            if (ok) s.lbl.pb({ addr, name });
+        } else if (rec.compare("lin") == 0) {
+            ok = (ls >> hex >> addr >> dec >> n >> mod >> ln) && addr + n <= mem_end + 1 && mod < s.srcs.size();
+            if (ok) fill(s.line.begin() + addr, s.line.begin() + addr + n, make_pair((uint16_t)mod, ln));
+        } else ok = rec.empty();
+        if (!ok) throw invalid_argument("Malformed symbol record on line " + to_string(c) + ".");
+    }
+    stable_sort(s.lbl.begin(), s.lbl.end(), [](const pair<uint16_t,string> &a, const pair<uint16_t,string> &b) { return a.first < b.first; });
+    return s;
+}
+
+// Class of a microop in the histogram.
+// @param instr     Microop.
+// @return          Class (cls_*).
+inline uint8_t mclass(const uint16_t instr) {
+    if (!(instr & 0x8000) && (instr & 0x1)) return cls_ljr;
+    switch (instr >> 14) {
+        case 0x0: return (instr & 0x200) ? cls_hlt : cls_nop;
+        case 0x1: return !(instr & 0x200) ? cls_movreg : (instr & 0x100) ? cls_stm : cls_ldm;
+        case 0x2: return cls_set;
+        default: return cls_exc + ((instr >> 7) & 0x7);
+    }
+}
+
+// Execution profile.
+// Microops are attributed to the nearest label before them, under the stack of functions being called: a CAL is a
+// jump through JR which leaves the address of the next microop in LR, a RET a jump through LR.
+struct profile {
+    const symbols &sym;
+    vector<uint32_t> at = vector<uint32_t>(mem_end+1); // Label index of every address (lbl.size(): none)
+    vector<uint64_t> hits = vector<uint64_t>(mem_end+1, 0); // Executed microops, by address
+    uint64_t cls[cls_hlt+1] = {}; // Executed microops, by class
+    vector<uint16_t> fn; // Function called by every stack (its top)
+    vector<uint32_t> parent; // Caller stack of every stack
+    vector<vector<uint64_t>> self; // Executed microops of every stack, by label index
+    unordered_map<uint64_t,uint32_t> child; // Stack reached from a stack by a call, by (stack, function)
+    unordered_map<uint16_t,uint64_t> calls; // Calls, by function
+    unordered_map<uint32_t,uint64_t> back; // Taken backward jumps, by (source, target)
+
+    profile(const symbols &s) : sym(s) {
+        for (uint32_t a = 0, i = 0; a <= mem_end; ++a) {
+            while (i < sym.lbl.size() && sym.lbl[i].first <= a) ++i;
+            at[a] = (i > 0) ? i - 1 : sym.lbl.size();
+        }
+        fn.pb(mem_iprg); // Root: the program
+        parent.pb(0);
+        self.pb(vector<uint64_t>(sym.lbl.size() + 1, 0));
+    }
+
+    // Stack reached by calling a function.
+    // @param s     Caller stack.
+    // @param f     Function address.
+    // @return      Callee stack.
+    uint32_t push(const uint32_t s, const uint16_t f) {
+        uint64_t key = ((uint64_t)s << 16) | f;
+        auto it = child.find(key);
+        if (it != child.end()) return it->second;
+        fn.pb(f);
+        parent.pb(s);
+        self.pb(vector<uint64_t>(sym.lbl.size() + 1, 0));
+        return child[key] = fn.size() - 1;
+    }
+};
+
+// Run the machine until it halts or a microop budget runs out, profiling its execution.
+// @param m         Machine.
+// @param max       Maximum number of microops to execute.
+// @param p         Profile (updated).
+// @return          Number of microops executed.
+inline uint64_t runProfiled(rc16 &m, const uint64_t max, profile &p) {
+    if (m.hlt) return 0;
+    uint64_t n = 0;
+    uint32_t s = 0; // Current stack
+    while (n < max) {
+        ++n;
+        uint16_t pc = m.r[PC], instr = m.mem[pc];
+        ++p.hits[pc];
+        ++p.self[s][p.at[pc]];
+        ++p.cls[mclass(instr)];
+        ++m.r[PC];
+        if (!exec(m, instr)) break;
+        uint16_t npc = m.r[PC];
+        if (npc == (uint16_t)(pc + 1)) continue;
+        if ((instr & 0xc201) == 0x4000 && ((instr >> 1) & 0xf) == PC) { // Jump (MOV <reg> PC)
+            uint8_t src = (instr >> 5) & 0xf;
+            if (src == JR && m.r[LR] == (uint16_t)(pc + 1)) { // CAL
+                s = p.push(s, npc);
+                ++p.calls[npc];
+                continue;
+            } else if (src == LR) { // RET
+                if (s > 0) s = p.parent[s];
+                continue;
+            }
+        }
+        if (npc <= pc) ++p.back[((uint32_t)pc << 16) | npc]; // Loop
+    }
+    m.cyc += n;
+    return n;
+}
+
+// Name of a function: its label, or its address.
+// @param sym       Symbols.
+// @param f         Function address.
+// @return          Name.
+inline string fnName(const symbols &sym, const uint16_t f) {
+    for (auto &l : sym.lbl) if (l.first == f) return l.second;
+    return "0x" + bin2hex(f);
+}
+
+// Write the profile as collapsed stacks ('<function>;...;<label> <microops>' lines), the input of flame graphs.
+// @param os        Output stream.
+// @param p         Profile.
+inline void writeFolded(ostream &os, const profile &p) {
+    for (uint32_t s = 0; s < p.fn.size(); ++s) {
+        string frames = "";
+        for (uint32_t t = s;; t = p.parent[t]) {
+            frames = fnName(p.sym, p.fn[t]) + (frames.empty() ? "" : ";") + frames;
+            if (t == 0) break;
+        }
+        for (size_t l = 0; l < p.self[s].size(); ++l) {
+            if (p.self[s][l] == 0) continue;
+            string leaf = (l < p.sym.lbl.size()) ? p.sym.lbl[l].second : "(none)";
+            os << frames << (leaf == fnName(p.sym, p.fn[s]) ? "" : ";" + leaf) << " " << p.self[s][l] << nl;
+        }
+    }
+}
+
+// Write a text summary of the profile: microops by label, function, loop, source line and class.
+// @param os        Output stream.
+// @param p         Profile.
+// @param top       Maximum number of rows of every table.
+inline void writeSummary(ostream &os, const profile &p, const size_t top = 20) {
+    uint64_t total = 0;
+    for (uint64_t h : p.hits) total += h;
+    auto pct = [&](const uint64_t v) { oss ps; ps << fixed << setprecision(1) << (total ? 100.0 * v / total : 0) << "%"; return ps.str(); };
+    auto row = [&](const string &name, const vector<string> &cols) {
+        os << "  " << left << setw(32) << name << right;
+        for (const string &c : cols) os << setw(14) << c;
+        os << nl;
+    };
+    auto where = [&](const uint16_t a) {
+        const pair<uint16_t,int> &l = p.sym.line[a];
+        return l.second > 0 ? p.sym.srcs[l.first] + ":" + to_string(l.second) : "0x" + bin2hex(a);
+    };
+    os << "Microops: " << total << nl;
+    // Labels
+    vector<pair<uint64_t,size_t>> rows;
+    vector<uint64_t> lbl(p.sym.lbl.size() + 1, 0);
+    for (auto &v : p.self) for (size_t l = 0; l < v.size(); ++l) lbl[l] += v[l];
+    for (size_t l = 0; l < lbl.size(); ++l) if (lbl[l] > 0) rows.pb({ lbl[l], l });
+    sort(rows.rbegin(), rows.rend());
+    os << nl << "Labels:" << nl;
+    row("label", { "microops", "share" });
+    for (size_t i = 0; i < min(top, rows.size()); ++i) row(rows[i].second < p.sym.lbl.size() ? p.sym.lbl[rows[i].second].second : "(none)", { to_string(rows[i].first), pct(rows[i].first) });
+    // Functions
+    unordered_map<uint16_t,uint64_t> incl, excl;
+    for (uint32_t s = 0; s < p.fn.size(); ++s) {
+        uint64_t t = 0;
+        for (uint64_t v : p.self[s]) t += v;
+        excl[p.fn[s]] += t;
+        vector<uint16_t> seen;
+        for (uint32_t u = s;; u = p.parent[u]) {
+            if (find(seen.begin(), seen.end(), p.fn[u]) == seen.end()) { seen.pb(p.fn[u]); incl[p.fn[u]] += t; } // Recursion counts once
+            if (u == 0) break;
+        }
+    }
+    vector<pair<uint64_t,uint16_t>> fns;
+    for (auto &f : incl) fns.pb({ f.second, f.first });
+    sort(fns.rbegin(), fns.rend());
+    os << nl << "Functions:" << nl;
+    row("function", { "calls", "inclusive", "exclusive" });
+    for (size_t i = 0; i < min(top, fns.size()); ++i) {
+        uint16_t f = fns[i].second;
+        auto c = p.calls.find(f);
+        row(fnName(p.sym, f), { to_string(c != p.calls.end() ? c->second : 1), to_string(incl[f]), to_string(excl[f]) });
+    }
+    // Loops
+    vector<pair<uint64_t,uint32_t>> loops;
+    for (auto &b : p.back) {
+        uint64_t body = 0;
+        for (uint32_t a = b.first & 0xffff; a <= b.first >> 16; ++a) body += p.hits[a];
+        loops.pb({ body, b.first });
+    }
+    sort(loops.rbegin(), loops.rend());
+    os << nl << "Hot loops:" << nl;
+    row("loop", { "iterations", "microops", "share" });
+    for (size_t i = 0; i < min(top, loops.size()); ++i) {
+        uint16_t from = loops[i].second >> 16, to = loops[i].second & 0xffff;
+        row(where(to) + " - " + where(from), { to_string(p.back.at(loops[i].second)), to_string(loops[i].first), pct(loops[i].first) });
+    }
+    // Source lines
+    map<pair<uint16_t,int>,uint64_t> lines;
+    for (uint32_t a = 0; a <= mem_end; ++a) if (p.hits[a] > 0 && p.sym.line[a].second > 0) lines[p.sym.line[a]] += p.hits[a];
+    vector<pair<uint64_t,pair<uint16_t,int>>> lrows;
+    for (auto &l : lines) lrows.pb({ l.second, l.first });
+    stable_sort(lrows.begin(), lrows.end(), [](const pair<uint64_t,pair<uint16_t,int>> &a, const pair<uint64_t,pair<uint16_t,int>> &b) { return a.first > b.first; });
+    os << nl << "Source lines:" << nl;
+    row("line", { "microops", "share" });
+    for (size_t i = 0; i < min(top, lrows.size()); ++i) row(p.sym.srcs[lrows[i].second.first] + ":" + to_string(lrows[i].second.second), { to_string(lrows[i].first), pct(lrows[i].first) });
+    // Classes
+    os << nl << "Microop classes:" << nl;
+    row("class", { "microops", "share" });
+    for (uint8_t c = cls_movreg; c <= cls_hlt; ++c) if (p.cls[c] > 0) row(cls_names[c], { to_string(p.cls[c]), pct(p.cls[c]) });
+}
+
+#endif
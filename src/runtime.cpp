@@ -0,0 +1,464 @@
+/**
+ * ===================
+ * RCC - RC16 COMPILER
+ * ===================
+ *
+ * RUNTIME LIBRARY
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef RTL
+#define RTL
+
+// Module of the runtime library, linked into a program only if the program references one of its entry points (and
+// does not define it). Routines take their arguments in R0, R1 and R2, and leave their result in R2 ('divmod' also in
+// R3); every other register but the flags is preserved. The cycles of every routine, written next to it, count the CAL.
+struct rtmod {
+    string_view name; // Module name (as reported in errors, listings and symbols)
+    string_view entries; // Entry points, separated by spaces
+    string_view src; // Source
+};
+
+constexpr rtmod runtime[] = {
+    { "rt/mul.rc", "mul", R"(# MULTIPLICATION
+# Shift and add, over the bits of the smaller factor from the most significant one (8 steps if it is below 256).
+# @param r0: n
+# @param r1: m
+# @result r2: n*m (low 16 bits)
+# Cycles (CAL included): 145 if either factor is below 256, 227 otherwise.
+.prgm
+    &mul
+        psh: {r3, r4}
+        mov: r3, r0
+        mov: r4, r1
+        cmp: r0, r1
+        movcc: r3, r1
+        movcc: r4, r0
+        set: r2, 8
+        lsrs: r2, r4, r2
+        jmpne: $mul_16
+        set: r2, 8
+        lsl: r4, r4, r2
+        set: r2, 0
+        jmp: $mul_8
+    &mul_16
+        set: r2, 0
+        adds: r4, r4, r4
+        movcs: r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+    &mul_8
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        add: r2, r2, r2
+        adds: r4, r4, r4
+        addcs: r2, r2, r3
+        pop: {r3, r4}
+        ret
+)" },
+    { "rt/div.rc", "divmod div mod", R"(# DIVISION AND REMAINDER
+# Restoring division, over the bits of the dividend from the most significant one (8 steps if it is below 256).
+# Division by zero gives 0xffff, remainder n.
+# @param r0: n
+# @param r1: d
+# @result r2: n/d (unsigned)
+# @result r3: n%d (unsigned)
+# Cycles (CAL included): 228 if n is below 256, 405 otherwise, 37 if d is 32768 or more (204, 357 and 34 with -O).
+.prgm
+    &divmod
+        psh: r4
+        set: r4, 1
+        mov: r2, r0
+        orrs: r3, r1, r1
+        jmplt: $divmod_1
+        jmpeq: $divmod_0
+        set: r3, 8
+        lsrs: r3, r2, r3
+        jmpne: $divmod_16
+        set: r3, 8
+        lsl: r2, r2, r3
+        set: r3, 0
+        jmp: $divmod_8
+    &divmod_1
+        mov: r3, r0
+        set: r2, 0
+        cmp: r0, r1
+        subcs: r3, r3, r1
+        setcs: r2, 1
+        pop: r4
+        ret
+    &divmod_16
+        set: r3, 0
+    &divmod_0
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+    &divmod_8
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        adds: r2, r2, r2
+        add: r3, r3, r3
+        addcs: r3, r3, r4
+        cmp: r3, r1
+        subcs: r3, r3, r1
+        addcs: r2, r2, r4
+        pop: r4
+        ret
+
+# DIVISION
+# @param r0: n
+# @param r1: d
+# @result r2: n/d (unsigned)
+# Cycles: 27 more than 'divmod'.
+    &div
+        psh: {r3, lr}
+        cal: $divmod
+        pop: {r3, lr}
+        ret
+
+# REMAINDER
+# @param r0: n
+# @param r1: d
+# @result r2: n%d (unsigned)
+# Cycles: 28 more than 'divmod'.
+    &mod
+        psh: {r3, lr}
+        cal: $divmod
+        mov: r2, r3
+        pop: {r3, lr}
+        ret
+)" },
+    { "rt/memcpy.rc", "memcpy", R"(# MEMORY COPY
+# Copies forwards, 4 words per iteration.
+# @param r0: destination address
+# @param r1: source address
+# @param r2: number of words n (clobbered)
+# Cycles (CAL included): 96 + 54*(n/4) (95 + 46*(n/4) with -O).
+.prgm
+    &memcpy
+        psh: {r0, r1, r3, r4}
+        set: r4, 1
+        ands: r3, r2, r4
+        ldrne: r3, r1
+        strne: r0, r3
+        addne: r1, r1, r4
+        addne: r0, r0, r4
+        set: r3, 2
+        ands: r3, r2, r3
+        ldrne: r3, r1
+        strne: r0, r3
+        addne: r1, r1, r4
+        addne: r0, r0, r4
+        ldrne: r3, r1
+        strne: r0, r3
+        addne: r1, r1, r4
+        addne: r0, r0, r4
+        set: r3, 2
+        lsrs: r2, r2, r3
+        jmpeq: $memcpy_end
+    &memcpy_4
+        ldr: r3, r1
+        str: r0, r3
+        add: r1, r1, r4
+        add: r0, r0, r4
+        ldr: r3, r1
+        str: r0, r3
+        add: r1, r1, r4
+        add: r0, r0, r4
+        ldr: r3, r1
+        str: r0, r3
+        add: r1, r1, r4
+        add: r0, r0, r4
+        ldr: r3, r1
+        str: r0, r3
+        add: r1, r1, r4
+        add: r0, r0, r4
+        subs: r2, r2, r4
+        jmpne: $memcpy_4
+    &memcpy_end
+        pop: {r0, r1, r3, r4}
+        ret
+)" },
+    { "rt/memset.rc", "memset", R"(# MEMORY FILL
+# Fills forwards, 4 words per iteration.
+# @param r0: destination address
+# @param r1: value
+# @param r2: number of words n (clobbered)
+# Cycles (CAL included): 70 + 30*(n/4) (70 + 26*(n/4) with -O).
+.prgm
+    &memset
+        psh: {r0, r3, r4}
+        set: r4, 1
+        ands: r3, r2, r4
+        strne: r0, r1
+        addne: r0, r0, r4
+        set: r3, 2
+        ands: r3, r2, r3
+        strne: r0, r1
+        addne: r0, r0, r4
+        strne: r0, r1
+        addne: r0, r0, r4
+        set: r3, 2
+        lsrs: r2, r2, r3
+        jmpeq: $memset_end
+    &memset_4
+        str: r0, r1
+        add: r0, r0, r4
+        str: r0, r1
+        add: r0, r0, r4
+        str: r0, r1
+        add: r0, r0, r4
+        str: r0, r1
+        add: r0, r0, r4
+        subs: r2, r2, r4
+        jmpne: $memset_4
+    &memset_end
+        pop: {r0, r3, r4}
+        ret
+)" },
+    { "rt/prtdec.rc", "prtdec", R"(# DECIMAL PRINT
+# Prints the decimal digits of a number, from the most significant one, without leading zeros. Every digit is
+# found by subtracting 8, 4, 2 and 1 times its power of ten.
+# @param r0: n (unsigned)
+# @result r2: clobbered
+# Cycles (CAL included): 293 (248 with -O).
+.prgm
+    &prtdec
+        psh: {r0, r1, r3, r4}
+        mov: r2, r0
+        set: r1, 0
+        set: r4, 0
+        put: r3, 40000
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        setcs: r4, 4
+        put: r3, 20000
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 2
+        orrcs: r4, r4, r0
+        put: r3, 10000
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 1
+        orrcs: r4, r4, r0
+        orrs: r1, r1, r4
+        prtne: r4
+        set: r4, 0
+        put: r3, 8000
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        setcs: r4, 8
+        put: r3, 4000
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 4
+        orrcs: r4, r4, r0
+        put: r3, 2000
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 2
+        orrcs: r4, r4, r0
+        put: r3, 1000
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 1
+        orrcs: r4, r4, r0
+        orrs: r1, r1, r4
+        prtne: r4
+        set: r4, 0
+        put: r3, 800
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        setcs: r4, 8
+        put: r3, 400
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 4
+        orrcs: r4, r4, r0
+        put: r3, 200
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 2
+        orrcs: r4, r4, r0
+        put: r3, 100
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 1
+        orrcs: r4, r4, r0
+        orrs: r1, r1, r4
+        prtne: r4
+        set: r4, 0
+        put: r3, 80
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        setcs: r4, 8
+        set: r3, 40
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 4
+        orrcs: r4, r4, r0
+        set: r3, 20
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 2
+        orrcs: r4, r4, r0
+        set: r3, 10
+        cmp: r2, r3
+        subcs: r2, r2, r3
+        set: r0, 1
+        orrcs: r4, r4, r0
+        orrs: r1, r1, r4
+        prtne: r4
+        prt: r2
+        pop: {r0, r1, r3, r4}
+        ret
+)" },
+};
+
+// Find the module of the runtime library defining a label.
+// @param lbl       Label (lowercase).
+// @return          Module, or nullptr if no module defines the label.
+constexpr const rtmod *rtlabel(const string_view lbl) {
+    for (const rtmod &m : runtime) {
+        for (size_t pos = 0, end; pos < m.entries.length(); pos = end + 1) {
+            end = min(m.entries.find(' ', pos), m.entries.length());
+            if (m.entries.substr(pos, end - pos) == lbl) return &m;
+        }
+    }
+    return nullptr;
+}
+
+// Find a module of the runtime library by name.
+// @param name      Module name.
+// @return          Module, or nullptr if there is no such module.
+constexpr const rtmod *rtmodule(const string_view name) {
+    for (const rtmod &m : runtime) if (m.name == name) return &m;
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * ===================
+ * RCE - RC16 EMULATOR
+ * ===================
+ *
+ * SNAPSHOTS
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef SNP
+#define SNP
+
+// Snapshot file format (every field little-endian 16-bit words):
+//   char[4] "RCSS", version (1), number of stored pages
+//   register file (16 words), flags | halted << 8, executed microops (4 words, low first),
+//   number of outputs (2 words, low first), outputs,
+//   per stored page: page number, page words
+// Pages which are not stored are zero.
+#define snp_ver         0x1
+#define snp_head        (4 + 16 + 1 + 4 + 2) // Words before the outputs
+
+typedef array<uint16_t,pg_words> page;
+
+// Saved state of a machine. Memory is kept by page, and pages of zeros are not stored.
+struct snapshot {
+    uint16_t r[16] = {}; // Register file (see 'rc16')
+    uint8_t flg = 0; // Flags register
+    bool hlt = false; // Halted
+    uint64_t cyc = 0; // Executed microops
+    vector<uint16_t> out; // Values written to the output register
+    array<unique_ptr<page>,pg_count> pg; // Memory pages (null: zeros)
+};
+
+// Take a snapshot of a machine.
+// @param m         Machine.
+// @return          Snapshot.
+inline snapshot save(const rc16 &m) {
+    snapshot s;
+    copy(m.r, m.r + 16, s.r);
+    s.flg = m.flg;
+    s.hlt = m.hlt;
+    s.cyc = m.cyc;
+    s.out = m.out;
+    for (size_t p = 0; p < pg_count; ++p) {
+        const uint16_t *w = m.mem + (p << pg_bits);
+        if (all_of(w, w + pg_words, [](const uint16_t v) { return v == 0; })) continue;
+        s.pg[p] = make_unique<page>();
+        copy(w, w + pg_words, s.pg[p]->begin());
+    }
+    return s;
+}
+
+// Bring a machine back to a snapshot. Predecoded or translated code of the machine must be dropped afterwards.
+// @param m         Machine.
+// @param s         Snapshot.
+inline void restore(rc16 &m, const snapshot &s) {
+    copy(s.r, s.r + 16, m.r);
+    m.flg = s.flg;
+    m.hlt = s.hlt;
+    m.cyc = s.cyc;
+    m.out = s.out;
+    for (size_t p = 0; p < pg_count; ++p) {
+        uint16_t *w = m.mem + (p << pg_bits);
+        if (s.pg[p]) copy(s.pg[p]->begin(), s.pg[p]->end(), w);
+        else fill(w, w + pg_words, 0);
+    }
+}
+
+// Write a snapshot to a file: zero pages are left out.
+// @param os        Output stream (binary).
+// @param s         Snapshot.
+inline void writeSnap(ostream &os, const snapshot &s) {
+    vector<uint16_t> w = { 'R' | ('C' << 8), 'S' | ('S' << 8), snp_ver, 0 };
+    w.insert(w.end(), s.r, s.r + 16);
+    w.pb(s.flg | (s.hlt << 8));
+    for (int i = 0; i < 4; ++i) w.pb(s.cyc >> (16 * i));
+    w.pb(s.out.size() & 0xffff);
+    w.pb(s.out.size() >> 16);
+    w.insert(w.end(), s.out.begin(), s.out.end());
+    for (size_t p = 0; p < pg_count; ++p) {
+        if (!s.pg[p]) continue;
+        ++w[3];
+        w.pb(p);
+        w.insert(w.end(), s.pg[p]->begin(), s.pg[p]->end());
+    }
+    string buf(2 * w.size(), '\0');
+    for (size_t i = 0; i < w.size(); ++i) { buf[2*i] = w[i] & 0xff; buf[2*i+1] = w[i] >> 8; }
+    os << buf;
+}
+
+// Read a snapshot written by 'writeSnap'.
+// @param file      Snapshot file name.
+// @return          Snapshot.
+inline snapshot readSnap(const string &file) {
+    ifs in(file, ios::binary);
+    if (!in) throw invalid_argument("Given snapshot does not exist or is unaccessible.");
+    uint16_t h[snp_head];
+    if (!readLe(in, h, snp_head) || h[0] != ('R' | ('C' << 8)) || h[1] != ('S' | ('S' << 8))) throw invalid_argument("Not a snapshot.");
+    if (h[2] != snp_ver) throw invalid_argument("Unsupported snapshot version " + to_string(h[2]) + ".");
+    snapshot s;
+    copy(h + 4, h + 20, s.r);
+    s.flg = h[20] & 0xf;
+    s.hlt = h[20] >> 8;
+    for (int i = 0; i < 4; ++i) s.cyc |= (uint64_t)h[21+i] << (16 * i);
+    s.out.resize(h[25] | ((uint32_t)h[26] << 16));
+    if (!readLe(in, s.out.data(), s.out.size())) throw invalid_argument("Truncated snapshot.");
+    for (uint16_t i = 0; i < h[3]; ++i) {
+        uint16_t p;
+        unique_ptr<page> c = make_unique<page>();
+        if (!readLe(in, &p, 1) || !readLe(in, c->data(), pg_words)) throw invalid_argument("Truncated snapshot.");
+        if (p >= pg_count) throw out_of_range("Page " + to_string(p) + " out of memory.");
+        s.pg[p] = move(c);
+    }
+    return s;
+}
+
+#endif
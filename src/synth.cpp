@@ -0,0 +1,201 @@
+/**
+ * ===================
+ * RCC - RC16 COMPILER
+ * ===================
+ *
+ * CONSTANT SYNTHESIS
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef SYN
+#define SYN
+
+// Ways of obtaining a value in OUT
+#define syn_not     0x0 // ~A
+#define syn_ak      0x1 // A <op> k (k loaded by SET B)
+#define syn_kb      0x2 // k <op> B (B loaded from OUT, k by SET A)
+#define syn_inf     0xff // Value not reached (yet)
+
+// Known register contents.
+struct regvals {
+    uint8_t k = 0x0; // Bit 'r' set if R'r' is known to hold 'v[r]'
+    uint16_t v[8] = {};
+
+    // Record the value held by a register (PC is never recorded).
+    void set(const reg &r, const uint16_t val) { if (r < PC) { k |= 1 << r; v[r] = val; } }
+    // Forget the value held by a register.
+    void forget(const reg &r) { if (r <= PC) k &= ~(1 << r); }
+    // Forget every value.
+    void clear() { k = 0x0; }
+    // Check whether a register holds a known value.
+    bool has(const uint8_t r) const { return (k >> r) & 0x1; }
+};
+
+// Last step of the cheapest sequence leaving a value in OUT.
+struct synstep {
+    uint8_t kind; // syn_not, syn_ak or syn_kb
+    uint8_t op; // ALU op-code
+    bool notb; // ALU '~B' flag
+    uint8_t k; // Immediate
+    uint16_t pre; // Value held by A (syn_not, syn_ak) or B (syn_kb) before the EXC
+};
+
+// Cheapest sequences for every 16-bit value, starting from unknown registers.
+// A is loaded by 'SET A k' (k <= maxval, 1 microop) or 'MOV OUT A' (1 microop after a sequence leaving the value in OUT).
+struct syntab {
+    uint8_t ca[mem_end+1]; // Microops to load each value into A
+    uint8_t co[mem_end+1]; // Microops to leave each value in OUT
+    synstep o[mem_end+1]; // Last step of the cheapest sequence leaving each value in OUT
+};
+
+// ALU operations worth trying on 'A <op> k': those whose result may exceed 6 bits. Shifts ignore the upper bits of B,
+// so they only need k <= 0xf and no '~B'.
+constexpr uint8_t syn_akops[][2] = { {ADD,0}, {ADD,1}, {AND,1}, {ORR,0}, {ORR,1}, {EOR,0}, {EOR,1}, {LSL,0}, {LSR,0}, {ASR,0} };
+// ALU operations worth trying on 'k <op> B': only those 'A <op> k' cannot express, since the others commute.
+constexpr uint8_t syn_kbops[][2] = { {ADD,1}, {ORR,1} };
+#define syn_kmax(op)    ((op <= EOR) ? maxval : 0xf) // Largest useful immediate for an op-code
+
+// Compute the output of an ALU operation, without flags.
+// @param a         Input A.
+// @param b         Input B.
+// @param op        ALU op-code.
+// @param notb      '~B' flag.
+// @return          ALU output.
+constexpr uint16_t aluval(const uint16_t a, uint16_t b, const uint8_t op, const bool notb) {
+    if (notb) b = ~b;
+    switch (op) {
+        case ADD: return a + b + notb;
+        case AND: return a & b;
+        case ORR: return a | b;
+        case EOR: return a ^ b;
+        case NOT: return ~a;
+        case LSL: return a << (b & 0xf);
+        case LSR: return a >> (b & 0xf);
+        default: return (int16_t)a >> (b & 0xf); // ASR
+    }
+}
+
+// Build the table of cheapest sequences by a shortest path search over the values held by A and OUT.
+// @return          Table (never freed).
+inline syntab *buildSyntab() {
+    syntab *t = new syntab();
+    fill(t->ca, t->ca + mem_end + 1, syn_inf);
+    fill(t->co, t->co + mem_end + 1, syn_inf);
+    vector<vector<uint32_t>> q(64); // Buckets by cost: value, plus 0x10000 for OUT
+    auto relaxA = [&](const uint16_t v, const uint8_t c) {
+        if (c >= t->ca[v]) return;
+        t->ca[v] = c;
+        q[c].pb(v);
+    };
+    auto relaxO = [&](const uint16_t v, const uint8_t c, const uint8_t kind, const uint8_t op, const bool nb, const uint8_t k, const uint16_t pre) {
+        if (c >= t->co[v]) return;
+        t->co[v] = c;
+        t->o[v] = { kind, op, nb, k, pre };
+        q[c].pb(0x10000 | v);
+    };
+    for (uint16_t k = minval; k <= maxval; ++k) relaxA(k, 1); // SET A k
+    for (size_t c = 1; c + 3 < q.size(); ++c) {
+        for (size_t i = 0; i < q[c].size(); ++i) {
+            uint16_t v = q[c][i] & 0xffff;
+            if (!(q[c][i] & 0x10000)) { // A holds v
+                if (t->ca[v] != c) continue;
+                relaxO(~v, c+1, syn_not, NOT, false, 0, v); // EXC NOT
+                for (auto &o : syn_akops) for (uint16_t k = minval; k <= syn_kmax(o[0]); ++k) {
+                    uint16_t r = aluval(v, k, o[0], o[1]);
+                    if (c+2 < t->co[r]) relaxO(r, c+2, syn_ak, o[0], o[1], k, v); // SET B k, EXC
+                }
+            } else { // OUT holds v
+                if (t->co[v] != c) continue;
+                relaxA(v, c+1); // MOV OUT A
+                for (auto &o : syn_kbops) for (uint16_t k = minval; k <= maxval; ++k) {
+                    uint16_t r = aluval(k, v, o[0], o[1]);
+                    if (c+3 < t->co[r]) relaxO(r, c+3, syn_kb, o[0], o[1], k, v); // MOV OUT B, SET A k, EXC
+                }
+            }
+        }
+        q[c].clear();
+    }
+    return t;
+}
+
+// Table of cheapest sequences, built on first use.
+// @return          Table.
+inline const syntab &synthesis() {
+    static const syntab *t = buildSyntab();
+    return *t;
+}
+
+// Emit the cheapest sequence loading a value into A.
+// @param o         Code buffer (appended to).
+// @param v         Value.
+// @param c         Conditional.
+inline void synA(vector<uint16_t> &o, const uint16_t v, const cond &c);
+
+// Emit the cheapest sequence leaving a value in OUT.
+// @param o         Code buffer (appended to).
+// @param v         Value.
+// @param c         Conditional.
+inline void synO(vector<uint16_t> &o, const uint16_t v, const cond &c) {
+    const synstep &s = synthesis().o[v];
+    if (s.kind == syn_kb) {
+        synO(o, s.pre, c);
+        o.pb(MOVREG(OUT, B, c));
+        o.pb(SET(A, s.k, c));
+    } else {
+        synA(o, s.pre, c);
+        if (s.kind == syn_ak) o.pb(SET(B, s.k, c));
+    }
+    o.pb(EXC((alu_op)s.op, s.notb, false, c));
+}
+
+inline void synA(vector<uint16_t> &o, const uint16_t v, const cond &c) {
+    if (v <= maxval) o.pb(SET(A, v, c));
+    else {
+        synO(o, v, c);
+        o.pb(MOVREG(OUT, A, c));
+    }
+}
+
+// Emit the shortest known microop sequence loading a 16-bit constant into a register.
+// Besides the table, tries direct SETs and MOVs and a single ALU operation on registers known to hold a value.
+// A, B and OUT are clobbered unless a single SET or MOV does the job.
+// @param o         Code buffer (appended to).
+// @param r         Destination register.
+// @param v         Value.
+// @param c         Conditional.
+// @param known     Known register contents.
+inline void synth(vector<uint16_t> &o, const reg &r, const uint16_t v, const cond &c, const regvals &known) {
+    if (v <= maxval && ireg(r)) { o.pb(SET(r, v, c)); return; }
+    for (uint8_t i = R0; i <= R7; ++i) if (known.has(i) && known.v[i] == v) { o.pb(MOVREG((reg)i, r, c)); return; }
+    // Single ALU operation with at least one known operand: MOV <rk> A, [SET B k | MOV <rj> B | MOV <rk> B, SET A k], EXC
+    int best = synthesis().co[v]; // Microops leaving v in OUT
+    int8_t ra = -1, rb = -1; // Known registers loaded into A and B (-1: immediate or unused)
+    uint8_t bop = NOT, bk = 0;
+    bool bnb = false;
+    for (uint8_t i = R0; i <= R7 && best > 2; ++i) {
+        if (!known.has(i)) continue;
+        if ((uint16_t)~known.v[i] == v) { best = 2; ra = i; rb = -1; bop = NOT; }
+        for (uint8_t op = ADD; op <= ASR; ++op) for (uint8_t nb = 0; nb <= 1 && best > 3; ++nb) {
+            for (uint16_t k = minval; k <= maxval && best > 3; ++k) {
+                if (aluval(known.v[i], k, op, nb) == v) { best = 3; ra = i; rb = -1; bop = op; bnb = nb; bk = k; }
+                else if (aluval(k, known.v[i], op, nb) == v) { best = 3; ra = -1; rb = i; bop = op; bnb = nb; bk = k; }
+            }
+            for (uint8_t j = R0; j <= R7 && best > 3; ++j)
+                if (known.has(j) && aluval(known.v[i], known.v[j], op, nb) == v) { best = 3; ra = i; rb = j; bop = op; bnb = nb; }
+        }
+    }
+    if (ra < 0 && rb < 0) synO(o, v, c);
+    else {
+        if (ra >= 0) o.pb(MOVREG((reg)ra, A, c));
+        else o.pb(SET(A, bk, c));
+        if (bop != NOT) {
+            if (rb >= 0) o.pb(MOVREG((reg)rb, B, c));
+            else o.pb(SET(B, bk, c));
+        }
+        o.pb(EXC((alu_op)bop, bnb, false, c));
+    }
+    o.pb(MOVREG(OUT, r, c));
+}
+
+#endif
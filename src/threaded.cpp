@@ -0,0 +1,179 @@
+/**
+ * ===================
+ * RCE - RC16 EMULATOR
+ * ===================
+ *
+ * PREDECODED THREADED INTERPRETER
+ * Davide Della Giustina
+ * 17/10/2026
+ */
+
+#ifndef THR
+#define THR
+
+// Handlers of predecoded microops
+enum hnd : uint8_t { H_DEC, H_NOP, H_HLT, H_LJR, H_MOV, H_MOVO, H_LDM, H_LDMO, H_STM, H_SET, H_SETO, H_ADD, H_AND, H_ORR, H_EOR, H_NOT, H_LSL, H_LSR, H_ASR, H_EXCF, H_CND };
+
+// Predecoded microop.
+struct pdop {
+    const void *h; // Handler address (H_CND for conditional microops)
+    uint16_t msk; // Condition mask (see 'cnd_mask')
+    uint16_t imm; // Immediate value, jump target or '~B' mask (0xffff if set)
+    uint8_t k; // Handler of the microop proper
+    uint8_t a; // Source slot, or ALU op-code for flag-setting EXCs
+    uint8_t b; // Destination slot, or '~B' flag for flag-setting EXCs
+};
+
+// Predecoded microop cache: one entry per memory word, decoded on first execution and invalidated on write.
+struct pdcache {
+    vector<pdop> e = vector<pdop>(mem_end+1);
+    bool init = false; // Handlers bound
+};
+
+// Unpack a microop word.
+// @param instr     Microop.
+// @return          Predecoded microop (handler address not bound).
+inline pdop predecode(const uint16_t instr) {
+    pdop d = { nullptr, cnd_mask[(instr >> 10) & 0xf], 0x0, H_NOP, 0x0, 0x0 };
+    if (!(instr & 0x8000) && (instr & 0x1)) { // LJR
+        d.msk = cnd_mask[AL];
+        d.k = H_LJR;
+        d.imm = mem_iprg + ((instr >> 1) & 0x3fff);
+        return d;
+    }
+    switch (instr >> 14) {
+        case 0x0: // NOP, HLT
+            d.k = (instr & 0x200) ? H_HLT : H_NOP;
+            break;
+        case 0x1:
+            if (!(instr & 0x200)) { // MOV (reg->reg)
+                d.a = src_slot[(instr >> 5) & 0xf];
+                d.b = dst_slot[(instr >> 1) & 0xf];
+                d.k = (d.b == OR) ? H_MOVO : H_MOV;
+            } else if (instr & 0x100) { // MOV (reg->mem)
+                d.a = src_slot[(instr >> 4) & 0xf];
+                d.k = H_STM;
+            } else { // MOV (mem->reg)
+                d.b = dst_slot[(instr >> 4) & 0xf];
+                d.k = (d.b == OR) ? H_LDMO : H_LDM;
+            }
+            break;
+        case 0x2: // SET
+            d.b = dst_slot[(instr >> 6) & 0xf];
+            d.imm = instr & 0x3f;
+            d.k = (d.b == OR) ? H_SETO : H_SET;
+            break;
+        case 0x3: // EXC
+            if (instr & 0x20) { // Flag-setting: go through the full ALU model
+                d.k = H_EXCF;
+                d.a = (instr >> 7) & 0x7;
+                d.b = (instr >> 6) & 0x1;
+            } else {
+                d.k = H_ADD + ((instr >> 7) & 0x7);
+                d.imm = (instr & 0x40) ? 0xffff : 0x0;
+            }
+            break;
+    }
+    return d;
+}
+
+// Run the machine on the threaded interpreter until it halts or a microop budget runs out.
+// Words are decoded once into 'dc' and dispatched through computed gotos; stores invalidate the entry of the word they hit.
+// @param m         Machine.
+// @param max       Maximum number of microops to execute.
+// @param dc        Predecoded microop cache (must not be shared between machines).
+// @return          Number of microops executed.
+inline uint64_t runThreaded(rc16 &m, const uint64_t max, pdcache &dc) {
+    static const void *const tbl[] = { &&h_dec, &&h_nop, &&h_hlt, &&h_ljr, &&h_mov, &&h_movo, &&h_ldm, &&h_ldmo, &&h_stm, &&h_set, &&h_seto,
+        &&h_add, &&h_and, &&h_orr, &&h_eor, &&h_not, &&h_lsl, &&h_lsr, &&h_asr, &&h_excf, &&h_cnd };
+    if (!dc.init) {
+        for (pdop &e : dc.e) e.h = tbl[H_DEC];
+        dc.init = true;
+    }
+    if (m.hlt || max == 0) return 0;
+    uint16_t *r = m.r, *mem = m.mem;
+    pdop *e = dc.e.data(), *d;
+    uint8_t flg = m.flg;
+    uint64_t left = max;
+    #define next()  { if (!--left) goto out; d = &e[r[PC]++]; goto *d->h; }
+    d = &e[r[PC]++];
+    goto *d->h;
+    h_dec: { // First execution (or first after a store): decode and bind handler
+        *d = predecode(mem[d - e]);
+        if (d->msk == cnd_mask[AL]) d->h = tbl[d->k];
+        else d->h = tbl[H_CND];
+        goto *d->h;
+    }
+    h_cnd:
+        if (!((d->msk >> flg) & 0x1)) next();
+        goto *tbl[d->k];
+    h_nop:
+        next();
+    h_hlt:
+        m.hlt = true;
+        --r[PC]; // Stay on the HLT
+        --left;
+        goto out;
+    h_ljr:
+        r[JR] = d->imm;
+        next();
+    h_mov:
+        r[d->b] = r[d->a];
+        next();
+    h_movo:
+        r[OR] = r[d->a];
+        m.out.pb(r[OR]);
+        next();
+    h_ldm:
+        r[d->b] = mem[r[MAR]];
+        next();
+    h_ldmo:
+        r[OR] = mem[r[MAR]];
+        m.out.pb(r[OR]);
+        next();
+    h_stm:
+        mem[r[MAR]] = r[d->a];
+        e[r[MAR]].h = tbl[H_DEC];
+        next();
+    h_set:
+        r[d->b] = d->imm;
+        next();
+    h_seto:
+        r[OR] = d->imm;
+        m.out.pb(r[OR]);
+        next();
+    h_add:
+        r[OUT] = r[A] + (r[B] ^ d->imm) + (d->imm & 0x1);
+        next();
+    h_and:
+        r[OUT] = r[A] & (r[B] ^ d->imm);
+        next();
+    h_orr:
+        r[OUT] = r[A] | (r[B] ^ d->imm);
+        next();
+    h_eor:
+        r[OUT] = r[A] ^ (r[B] ^ d->imm);
+        next();
+    h_not:
+        r[OUT] = ~r[A];
+        next();
+    h_lsl:
+        r[OUT] = r[A] << ((r[B] ^ d->imm) & 0xf);
+        next();
+    h_lsr:
+        r[OUT] = r[A] >> ((r[B] ^ d->imm) & 0xf);
+        next();
+    h_asr:
+        r[OUT] = (int16_t)r[A] >> ((r[B] ^ d->imm) & 0xf);
+        next();
+    h_excf:
+        r[OUT] = alu(r[A], r[B], d->a, d->b, flg);
+        next();
+    #undef next
+    out:
+    m.flg = flg;
+    m.cyc += max - left;
+    return max - left;
+}
+
+#endif